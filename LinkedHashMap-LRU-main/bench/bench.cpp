@@ -0,0 +1,524 @@
+/**
+ * throughput of hashmap, linked_hashmap and lru against the standard
+ * containers doing the same work:
+ *   hashmap        <-> std::unordered_map
+ *   linked_hashmap <-> std::unordered_map + std::list
+ *   lru            <-> std::unordered_map + std::list (splice on hit)
+ * build and run from this directory:
+ *   g++ -std=c++17 -O2 -DNDEBUG -I../lru bench.cpp -o bench && ./bench
+ * options:
+ *   --max-size N   largest size run (default 10000000)
+ *   --budget MB    skip a case whose values would take more (default 2048)
+ *   --only NAME    run only the structures whose name contains NAME
+ * each line is: structure, operation, key distribution, value type,
+ * size, nanoseconds per operation
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "src.hpp"
+
+namespace {
+using clock_type = std::chrono::steady_clock;
+
+// results are folded in here so that no work is optimized away
+volatile unsigned long long sink;
+
+enum distribution { sequential, uniform, zipf };
+const char* const distribution_names[] = {"sequential", "uniform", "zipf"};
+
+/**
+ * splitmix64, deterministic across runs
+ */
+struct random_source {
+    unsigned long long state;
+    explicit random_source(unsigned long long seed) : state(seed) {}
+    unsigned long long next() {
+        unsigned long long z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+    double unit() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+};
+
+/**
+ * zipf ranks in [0, n) with exponent theta, O(1) per draw after an
+ * O(n) setup (Gray et al., "Quickly generating billion-record
+ * synthetic databases")
+ */
+class zipf_source {
+    size_t n;
+    double theta, alpha, zetan, eta;
+
+   public:
+    zipf_source(size_t n, double theta) : n(n), theta(theta) {
+        double zeta2 = 1 + std::pow(0.5, theta);
+        zetan = 0;
+        for (size_t i = 1; i <= n; i++)
+            zetan += 1 / std::pow((double)i, theta);
+        alpha = 1 / (1 - theta);
+        eta = (1 - std::pow(2.0 / n, 1 - theta)) / (1 - zeta2 / zetan);
+    }
+    size_t draw(random_source& random) const {
+        double u = random.unit();
+        double uz = u * zetan;
+        if (uz < 1)
+            return 0;
+        if (uz < 1 + std::pow(0.5, theta))
+            return 1;
+        size_t rank = (size_t)(n * std::pow(eta * u - eta + 1, alpha));
+        return rank < n ? rank : n - 1;
+    }
+};
+
+/**
+ * the key of the index-th entry: sequential keys are 0..n-1, the
+ * others are scattered over the int range so that neighbouring
+ * indices do not share buckets; index n..2n-1 gives keys never
+ * inserted
+ */
+int key_of(distribution d, size_t index) {
+    if (d == sequential)
+        return (int)index;
+    return (int)(unsigned)(index * 2654435761u);
+}
+
+/**
+ * the indices a run touches, in order: every index once for inserts
+ * and removes, count draws for lookups
+ */
+std::vector<size_t> order_of(distribution d, size_t n, bool once) {
+    std::vector<size_t> order(n);
+    random_source random(n * 31 + d);
+    for (size_t i = 0; i < n; i++)
+        order[i] = i;
+    if (d == sequential)
+        return order;
+    if (once || d == uniform) {
+        if (once) {
+            for (size_t i = n - 1; i > 0; i--)
+                std::swap(order[i], order[random.next() % (i + 1)]);
+        } else {
+            for (size_t i = 0; i < n; i++)
+                order[i] = random.next() % n;
+        }
+        return order;
+    }
+    zipf_source ranks(n, 0.99);
+    for (size_t i = 0; i < n; i++)
+        order[i] = ranks.draw(random);
+    return order;
+}
+
+/**
+ * the value types: a single Integer, a 2x2 and a 32x32 matrix
+ */
+struct integer_value {
+    using type = Integer;
+    static const char* name() { return "Integer"; }
+    static size_t bytes() { return sizeof(Integer); }
+    static type make(size_t i) { return Integer((int)i); }
+    static unsigned long long fold(const type& v) { return v.val; }
+};
+template <size_t N>
+struct matrix_value {
+    using type = Matrix<int>;
+    static const char* name() { return N == 2 ? "Matrix2x2" : "Matrix32x32"; }
+    static size_t bytes() { return N * N * sizeof(int) + sizeof(Matrix<int>); }
+    static type make(size_t i) { return Matrix<int>(N, N, (int)i); }
+    static unsigned long long fold(const type& v) { return v[0][0]; }
+};
+
+struct std_hash {
+    size_t operator()(const Integer& key) const { return Hash()(key); }
+};
+struct std_equal {
+    bool operator()(const Integer& lhs, const Integer& rhs) const {
+        return lhs.val == rhs.val;
+    }
+};
+
+/**
+ * times f(), repeated until at least min_ops operations were done,
+ * and reports the time per operation; f returns its operation count
+ */
+template <class F>
+double measure(F&& f, size_t min_ops) {
+    size_t ops = 0;
+    clock_type::duration spent(0);
+    while (ops < min_ops) {
+        clock_type::time_point start = clock_type::now();
+        ops += f();
+        spent += clock_type::now() - start;
+    }
+    return std::chrono::duration<double, std::nano>(spent).count() / ops;
+}
+
+void report(const char* structure,
+            const char* op,
+            distribution d,
+            const char* value,
+            size_t n,
+            double ns) {
+    std::printf("%-16s %-10s %-11s %-12s %9zu %10.1f\n", structure, op,
+                distribution_names[d], value, n, ns);
+    std::fflush(stdout);
+}
+
+const size_t MIN_OPS = 1000000;
+
+/**
+ * the same for an operation that needs a full map to start with:
+ * the map is filled untimed before every run
+ */
+template <class Adapter, class Value, class F>
+double measure_full(const std::vector<Integer>& keys,
+                    const std::vector<Value>& values,
+                    F&& f) {
+    size_t ops = 0;
+    clock_type::duration spent(0);
+    while (ops < MIN_OPS) {
+        Adapter full;
+        for (size_t i = 0; i < keys.size(); i++)
+            full.insert(keys[i], values[i]);
+        clock_type::time_point start = clock_type::now();
+        f(full);
+        spent += clock_type::now() - start;
+        sink += full.size();
+        ops += keys.size();
+    }
+    return std::chrono::duration<double, std::nano>(spent).count() / ops;
+}
+
+/**
+ * the map benchmarks, the same for every structure through a small
+ * adapter: insert, find, erase, visit all, grow the table
+ */
+template <class Adapter, class V>
+void map_cases(distribution d, size_t n) {
+    std::vector<size_t> once = order_of(d, n, true);
+    std::vector<size_t> draws = order_of(d, n, false);
+    // keys: every key once, hits: keys drawn from the distribution
+    std::vector<Integer> keys, hits, misses;
+    std::vector<typename V::type> values;
+    keys.reserve(n);
+    hits.reserve(n);
+    misses.reserve(n);
+    values.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        keys.push_back(Integer(key_of(d, once[i])));
+        hits.push_back(Integer(key_of(d, draws[i])));
+        misses.push_back(Integer(key_of(d, draws[i] + n)));
+        values.push_back(V::make(once[i]));
+    }
+    const char* name = Adapter::name();
+
+    report(name, "insert", d, V::name(), n, measure([&] {
+               Adapter map;
+               for (size_t i = 0; i < n; i++)
+                   map.insert(keys[i], values[i]);
+               sink += map.size();
+               return n;
+           }, MIN_OPS));
+
+    Adapter map;
+    for (size_t i = 0; i < n; i++)
+        map.insert(keys[i], values[i]);
+    report(name, "find-hit", d, V::name(), n, measure([&] {
+               unsigned long long sum = 0;
+               for (size_t i = 0; i < n; i++)
+                   sum += V::fold(*map.find(hits[i]));
+               sink += sum;
+               return n;
+           }, MIN_OPS));
+    report(name, "find-miss", d, V::name(), n, measure([&] {
+               size_t found = 0;
+               for (size_t i = 0; i < n; i++)
+                   found += map.find(misses[i]) != nullptr;
+               sink += found;
+               return n;
+           }, MIN_OPS));
+    report(name, "iterate", d, V::name(), n, measure([&] {
+               sink += map.visit();
+               return n;
+           }, MIN_OPS));
+    report(name, "expand", d, V::name(), n,
+           measure_full<Adapter>(keys, values, [&](Adapter& full) {
+               full.expand();
+           }));
+
+    report(name, "remove", d, V::name(), n,
+           measure_full<Adapter>(keys, values, [&](Adapter& full) {
+               for (size_t i = n; i-- > 0;)
+                   full.erase(keys[i]);
+           }));
+}
+
+template <class V>
+struct sjtu_hashmap {
+    sjtu::hashmap<Integer, typename V::type, Hash, Equal> map;
+    static const char* name() { return "hashmap"; }
+    void insert(const Integer& key, const typename V::type& value) {
+        map.insert({key, value});
+    }
+    const typename V::type* find(const Integer& key) {
+        auto iter = map.find(key);
+        return iter == map.end() ? nullptr : &iter->second;
+    }
+    void erase(const Integer& key) { map.remove(key); }
+    unsigned long long visit() {
+        unsigned long long sum = 0;
+        for (size_t i = 0; i < map.capacity; i++)
+            for (auto it = map.buckets[i].begin(); it != map.buckets[i].end();
+                 it++)
+                sum += V::fold(it->second);
+        return sum;
+    }
+    void expand() { map.expand(); }
+    size_t size() const { return map.size; }
+};
+
+template <class V>
+struct std_hashmap {
+    std::unordered_map<Integer, typename V::type, std_hash, std_equal> map;
+    static const char* name() { return "unordered_map"; }
+    void insert(const Integer& key, const typename V::type& value) {
+        map.insert_or_assign(key, value);
+    }
+    const typename V::type* find(const Integer& key) {
+        auto iter = map.find(key);
+        return iter == map.end() ? nullptr : &iter->second;
+    }
+    void erase(const Integer& key) { map.erase(key); }
+    unsigned long long visit() {
+        unsigned long long sum = 0;
+        for (auto& entry : map)
+            sum += V::fold(entry.second);
+        return sum;
+    }
+    void expand() { map.rehash(map.bucket_count() * 2); }
+    size_t size() const { return map.size(); }
+};
+
+template <class V>
+struct sjtu_linked {
+    sjtu::linked_hashmap<Integer, typename V::type, Hash, Equal> map;
+    static const char* name() { return "linked_hashmap"; }
+    void insert(const Integer& key, const typename V::type& value) {
+        map.insert({key, value});
+    }
+    const typename V::type* find(const Integer& key) {
+        auto iter = map.find(key);
+        return iter == map.end() ? nullptr : &iter->second;
+    }
+    void erase(const Integer& key) {
+        auto iter = map.find(key);
+        if (iter != map.end())
+            map.remove(iter);
+    }
+    unsigned long long visit() {
+        unsigned long long sum = 0;
+        for (auto it = map.begin(); it != map.end(); it++)
+            sum += V::fold(it->second);
+        return sum;
+    }
+    void expand() { map.expand(); }
+    size_t size() const { return map.size(); }
+};
+
+template <class V>
+struct std_linked {
+    using entry = std::pair<Integer, typename V::type>;
+    std::list<entry> order;
+    std::unordered_map<Integer,
+                       typename std::list<entry>::iterator,
+                       std_hash,
+                       std_equal>
+        map;
+    static const char* name() { return "unordered+list"; }
+    void insert(const Integer& key, const typename V::type& value) {
+        auto iter = map.find(key);
+        if (iter != map.end()) {
+            iter->second->second = value;
+            order.splice(order.end(), order, iter->second);
+            return;
+        }
+        order.emplace_back(key, value);
+        map.emplace(key, --order.end());
+    }
+    const typename V::type* find(const Integer& key) {
+        auto iter = map.find(key);
+        return iter == map.end() ? nullptr : &iter->second->second;
+    }
+    void erase(const Integer& key) {
+        auto iter = map.find(key);
+        if (iter == map.end())
+            return;
+        order.erase(iter->second);
+        map.erase(iter);
+    }
+    unsigned long long visit() {
+        unsigned long long sum = 0;
+        for (auto& e : order)
+            sum += V::fold(e.second);
+        return sum;
+    }
+    void expand() { map.rehash(map.bucket_count() * 2); }
+    size_t size() const { return map.size(); }
+};
+
+/**
+ * a read-through cache of a quarter of the keys: get, save on a miss
+ */
+template <class V>
+struct std_lru {
+    using entry = std::pair<Integer, typename V::type>;
+    size_t capacity;
+    std::list<entry> order;
+    std::unordered_map<Integer,
+                       typename std::list<entry>::iterator,
+                       std_hash,
+                       std_equal>
+        map;
+    explicit std_lru(size_t capacity) : capacity(capacity) {
+        map.reserve(capacity);
+    }
+    typename V::type* get(const Integer& key) {
+        auto iter = map.find(key);
+        if (iter == map.end())
+            return nullptr;
+        order.splice(order.end(), order, iter->second);
+        return &iter->second->second;
+    }
+    void save(const Integer& key, const typename V::type& value) {
+        auto iter = map.find(key);
+        if (iter != map.end()) {
+            iter->second->second = value;
+            order.splice(order.end(), order, iter->second);
+            return;
+        }
+        order.emplace_back(key, value);
+        map.emplace(key, --order.end());
+        if (map.size() > capacity) {
+            map.erase(order.front().first);
+            order.pop_front();
+        }
+    }
+};
+
+template <class Cache, class V>
+size_t read_through(Cache& cache,
+                    const std::vector<Integer>& keys,
+                    const std::vector<typename V::type>& values,
+                    const std::vector<size_t>& draws) {
+    size_t hits = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (cache.get(keys[i]))
+            hits++;
+        else
+            cache.save(keys[i], values[draws[i] % values.size()]);
+    }
+    return hits;
+}
+
+template <class V>
+struct sjtu_cache {
+    sjtu::basic_lru<Integer, typename V::type, Hash, Equal> cache;
+    explicit sjtu_cache(size_t capacity) : cache((int)capacity) {}
+    typename V::type* get(const Integer& key) { return cache.get(key); }
+    void save(const Integer& key, const typename V::type& value) {
+        cache.save({key, value});
+    }
+};
+
+template <class V>
+void lru_cases(distribution d, size_t n) {
+    std::vector<size_t> draws = order_of(d, n, false);
+    std::vector<Integer> keys;
+    std::vector<typename V::type> values;
+    keys.reserve(n);
+    for (size_t i = 0; i < n; i++)
+        keys.push_back(Integer(key_of(d, draws[i])));
+    for (size_t i = 0; i < 1024 && i < n; i++)
+        values.push_back(V::make(i));
+    size_t capacity = n / 4 ? n / 4 : 1;
+    size_t hits = 0;
+    double ns = measure([&] {
+        sjtu_cache<V> cache(capacity);
+        hits = read_through<sjtu_cache<V>, V>(cache, keys, values, draws);
+        return n;
+    }, MIN_OPS);
+    report("lru", "get/save", d, V::name(), n, ns);
+    size_t std_hits = 0;
+    ns = measure([&] {
+        std_lru<V> cache(capacity);
+        std_hits = read_through<std_lru<V>, V>(cache, keys, values, draws);
+        return n;
+    }, MIN_OPS);
+    report("std_lru", "get/save", d, V::name(), n, ns);
+    // both are exact lrus: a different hit count means a broken run
+    if (hits != std_hits)
+        std::printf("hit counts differ: %zu %zu\n", hits, std_hits);
+}
+
+struct options {
+    size_t max_size = 10000000;
+    size_t budget = size_t(2048) << 20;
+    std::string only;
+    bool wants(const char* name) const {
+        return only.empty() || std::strstr(name, only.c_str());
+    }
+};
+
+template <class V>
+void run_value(const options& opt) {
+    for (size_t n = 1000; n <= opt.max_size; n *= 10) {
+        // linked_hashmap keeps two copies of every value
+        if (2 * n * V::bytes() > opt.budget)
+            break;
+        for (int d = sequential; d <= zipf; d++) {
+            distribution dist = (distribution)d;
+            if (opt.wants("hashmap"))
+                map_cases<sjtu_hashmap<V>, V>(dist, n);
+            if (opt.wants("unordered_map"))
+                map_cases<std_hashmap<V>, V>(dist, n);
+            if (opt.wants("linked_hashmap"))
+                map_cases<sjtu_linked<V>, V>(dist, n);
+            if (opt.wants("unordered+list"))
+                map_cases<std_linked<V>, V>(dist, n);
+            if (opt.wants("lru"))
+                lru_cases<V>(dist, n);
+        }
+    }
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    options opt;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!std::strcmp(argv[i], "--max-size")) {
+            opt.max_size = std::strtoull(argv[i + 1], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--budget")) {
+            opt.budget = size_t(std::strtoull(argv[i + 1], nullptr, 10)) << 20;
+        } else if (!std::strcmp(argv[i], "--only")) {
+            opt.only = argv[i + 1];
+        } else {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    std::printf("%-16s %-10s %-11s %-12s %9s %10s\n", "structure", "op",
+                "keys", "value", "size", "ns/op");
+    run_value<integer_value>(opt);
+    run_value<matrix_value<2>>(opt);
+    run_value<matrix_value<32>>(opt);
+    return 0;
+}
@@ -0,0 +1,215 @@
+#ifndef SJTU_ASYNC_LRU_HPP
+#define SJTU_ASYNC_LRU_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "lru.hpp"
+
+namespace sjtu {
+/**
+ * a fixed number of worker threads taking tasks in FIFO order
+ * the destructor runs the tasks already submitted, then joins
+ */
+class thread_pool {
+    std::vector<std::thread> workers;
+    std::deque<std::packaged_task<void()>> tasks;
+    std::mutex lock;
+    std::condition_variable ready;
+    bool stopping;
+
+    void work() {
+        while (true) {
+            std::packaged_task<void()> task;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                ready.wait(guard, [this] { return stopping || !tasks.empty(); });
+                if (tasks.empty())
+                    return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+   public:
+    thread_pool(size_t threads) : stopping(false) {
+        for (size_t i = 0; i < threads; i++)
+            workers.emplace_back([this] { work(); });
+    }
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+    ~thread_pool() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        ready.notify_all();
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    template <class F>
+    void submit(F&& f) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            tasks.emplace_back(std::forward<F>(f));
+        }
+        ready.notify_one();
+    }
+};
+
+/**
+ * a basic_lru that hands out futures instead of blocking on a miss
+ * a miss stores a pending entry (the shared_future of the load) and
+ * submits the loader to the executor; later gets of the same key
+ * share that future. when the load completes, the value goes through
+ * the normal save() and the pending entry is dropped.
+ * Executor needs submit(callable); every member is thread safe.
+ */
+template <class Key,
+          class Value,
+          class Hash = std::hash<Key>,
+          class Equal = std::equal_to<Key>,
+          class Executor = thread_pool>
+class async_lru {
+   public:
+    using cache_type = basic_lru<Key, Value, Hash, Equal>;
+    using key_arg = typename cache_type::key_arg;
+    using value_type = typename cache_type::value_type;
+    using future = std::shared_future<Value>;
+
+   private:
+    cache_type cache;
+    linked_hashmap<Key, future, Hash, Equal> pending;
+    Executor& executor;
+    std::mutex lock;
+    std::condition_variable idle;
+
+    static future ready(const Value& value) {
+        std::promise<Value> done;
+        done.set_value(value);
+        return done.get_future().share();
+    }
+    void finish(const Key& key) {
+        pending.remove(pending.find(key));
+        if (pending.empty())
+            idle.notify_all();
+    }
+    /**
+     * hand the load of owned to the executor, called without lock
+     */
+    template <class Loader>
+    void submit(const Key& owned,
+                Loader loader,
+                std::shared_ptr<std::promise<Value>> result) {
+        executor.submit([this, owned, loader, result]() {
+            std::exception_ptr error;
+            Value* loaded = nullptr;
+            try {
+                loaded = new Value(loader(owned));
+            } catch (...) {
+                error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> guard(lock);
+            cache.count_load(loaded != nullptr);
+            if (loaded) {
+                try {
+                    cache.save(value_type(owned, *loaded));
+                    result->set_value(*loaded);
+                } catch (...) {
+                    result->set_exception(std::current_exception());
+                }
+                delete loaded;
+            } else {
+                result->set_exception(error);
+            }
+            finish(owned);
+        });
+    }
+
+   public:
+    async_lru(int size, Executor& executor) : cache(size), executor(executor) {}
+    /**
+     * the loads still running must not outlive the cache
+     */
+    ~async_lru() { wait(); }
+
+    /**
+     * the future of the value of key: ready on a hit, the pending
+     * load on a miss that is already being loaded, a new load
+     * (loader(key) run by the executor) otherwise
+     */
+    template <class Loader>
+    future get(key_arg key, Loader loader) {
+        std::unique_lock<std::mutex> guard(lock);
+        Value* hit = cache.get(key);
+        if (hit)
+            return ready(*hit);
+        auto iter = pending.find(key);
+        if (iter != pending.end())
+            return iter->second;
+        auto result = std::make_shared<std::promise<Value>>();
+        future f = result->get_future().share();
+        pending.insert({key, f});
+        Key owned(key);
+        // the executor may run the load right here, which takes lock
+        guard.unlock();
+        try {
+            submit(owned, loader, result);
+        } catch (...) {
+            guard.lock();
+            result->set_exception(std::current_exception());
+            finish(owned);
+            throw;
+        }
+        return f;
+    }
+    /**
+     * copy the value out if it is cached, never loads
+     */
+    bool try_get(key_arg key, Value& out) {
+        std::lock_guard<std::mutex> guard(lock);
+        Value* hit = cache.get(key);
+        if (!hit)
+            return false;
+        out = *hit;
+        return true;
+    }
+    void save(const value_type& v) {
+        std::lock_guard<std::mutex> guard(lock);
+        cache.save(v);
+    }
+    size_t size() {
+        std::lock_guard<std::mutex> guard(lock);
+        return cache.size();
+    }
+    cache_stats stats() {
+        std::lock_guard<std::mutex> guard(lock);
+        return cache.stats();
+    }
+    void reset_stats() {
+        std::lock_guard<std::mutex> guard(lock);
+        cache.reset_stats();
+    }
+    size_t loading() {
+        std::lock_guard<std::mutex> guard(lock);
+        return pending.size();
+    }
+    /**
+     * block until no load is pending
+     */
+    void wait() {
+        std::unique_lock<std::mutex> guard(lock);
+        idle.wait(guard, [this] { return pending.empty(); });
+    }
+};
+}  // namespace sjtu
+
+#endif
@@ -0,0 +1,481 @@
+#ifndef SJTU_COMPACT_HASHMAP_HPP
+#define SJTU_COMPACT_HASHMAP_HPP
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include "lru.hpp"
+
+namespace sjtu {
+/**
+ * a linked_hashmap whose entries live in one contiguous slot array
+ * and whose links are 32-bit slot numbers: a slot holds its value
+ * and prev/next (insertion order), chain (bucket) and the hash, 16
+ * bytes in all, where linked_hashmap spends two 32-byte nodes and
+ * two copies of the value. the bucket heads are slot numbers too.
+ * removed slots are kept on a free list (through next) for reuse;
+ * when none is left the array doubles and the entries are moved, so
+ * iterators (a slot number) stay valid but pointers and references
+ * to values do not. at most 2^32 - 1 entries.
+ */
+template <class Key,
+          class T,
+          class Hash = std::hash<Key>,
+          class Equal = std::equal_to<Key>,
+          class Alloc = std::allocator<pair<const Key, T>>>
+class compact_linked_hashmap {
+   public:
+    using value_type = pair<const Key, T>;
+    using allocator_type = rebind_alloc<Alloc, value_type>;
+    using index = unsigned;
+    static constexpr index NIL = ~index(0);
+
+   private:
+    struct slot {
+        index prev;
+        index next;
+        index chain;
+        // mix_hash of the key's hash, masked to find the bucket
+        unsigned hash;
+        alignas(value_type) unsigned char storage[sizeof(value_type)];
+
+        value_type& value() {
+            return *std::launder(reinterpret_cast<value_type*>(storage));
+        }
+    };
+    using slot_alloc = rebind_alloc<Alloc, slot>;
+    using index_alloc = rebind_alloc<Alloc, index>;
+
+    slot* slots;
+    index* buckets;
+    // slots ever handed out (the rest of the array is untouched)
+    size_t used;
+    size_t slot_capacity;
+    // a power of two, at least 4/3 of slot_capacity
+    size_t bucket_count;
+    size_t elements;
+    index head;
+    index tail;
+    index free_head;
+    Hash hash;
+    Equal eq;
+    allocator_type alloc;
+
+   public:
+#ifdef SJTU_ALLOC_STATS
+    // the bucket array counts as buckets, the slot array as values
+    alloc_account allocations;
+#endif
+
+   private:
+    slot* make_slots(size_t n) {
+        slot_alloc a(alloc);
+        slot* made = std::allocator_traits<slot_alloc>::allocate(a, n);
+#ifdef SJTU_ALLOC_STATS
+        allocations.allocated(alloc_account::values, n * sizeof(slot));
+#endif
+        return made;
+    }
+    void destroy_slots(slot* s, size_t n) {
+#ifdef SJTU_ALLOC_STATS
+        allocations.freed(alloc_account::values, n * sizeof(slot));
+#endif
+        slot_alloc a(alloc);
+        std::allocator_traits<slot_alloc>::deallocate(a, s, n);
+    }
+    /**
+     * a new bucket array of n heads, the entries chained into it
+     * from the hashes kept in their slots
+     */
+    void make_buckets(size_t n) {
+        index_alloc a(alloc);
+        buckets = std::allocator_traits<index_alloc>::allocate(a, n);
+#ifdef SJTU_ALLOC_STATS
+        allocations.allocated(alloc_account::buckets, n * sizeof(index));
+#endif
+        bucket_count = n;
+        for (size_t b = 0; b < n; b++)
+            buckets[b] = NIL;
+        for (index i = head; i != NIL; i = slots[i].next) {
+            index& bucket = buckets[slots[i].hash & (n - 1)];
+            slots[i].chain = bucket;
+            bucket = i;
+        }
+    }
+    void destroy_buckets() {
+#ifdef SJTU_ALLOC_STATS
+        allocations.freed(alloc_account::buckets,
+                          bucket_count * sizeof(index));
+#endif
+        index_alloc a(alloc);
+        std::allocator_traits<index_alloc>::deallocate(a, buckets,
+                                                       bucket_count);
+    }
+    /**
+     * move the entries to an array of n slots, and grow the buckets
+     * along when they would be more than 3/4 full
+     */
+    void reallocate(size_t n) {
+        slot* moved = make_slots(n);
+        for (size_t i = 0; i < used; i++) {
+            slot& from = slots[i];
+            moved[i].prev = from.prev;
+            moved[i].next = from.next;
+            moved[i].chain = from.chain;
+            moved[i].hash = from.hash;
+        }
+        for (index i = head; i != NIL; i = slots[i].next) {
+            new (moved[i].storage) value_type(std::move(slots[i].value()));
+            slots[i].value().~value_type();
+        }
+        destroy_slots(slots, slot_capacity);
+        slots = moved;
+        slot_capacity = n;
+        size_t wanted = bucket_count;
+        while (wanted * 3 < slot_capacity * 4)
+            wanted *= 2;
+        if (wanted != bucket_count) {
+            destroy_buckets();
+            make_buckets(wanted);
+        }
+    }
+    index take_slot() {
+        if (free_head != NIL) {
+            index i = free_head;
+            free_head = slots[i].next;
+            return i;
+        }
+        if (used == slot_capacity) {
+            if (slot_capacity >= NIL)
+                throw std::runtime_error("compact_linked_hashmap is full");
+            size_t n = slot_capacity * 2;
+            reallocate(n < NIL ? n : NIL);
+        }
+        return index(used++);
+    }
+    void unlink(index i) {
+        slot& s = slots[i];
+        if (s.prev != NIL)
+            slots[s.prev].next = s.next;
+        else
+            head = s.next;
+        if (s.next != NIL)
+            slots[s.next].prev = s.prev;
+        else
+            tail = s.prev;
+    }
+    void link_back(index i) {
+        slots[i].prev = tail;
+        slots[i].next = NIL;
+        if (tail != NIL)
+            slots[tail].next = i;
+        else
+            head = i;
+        tail = i;
+    }
+    unsigned hash_of(const Key& key) const { return mix_hash(hash(key)); }
+    index find_index(const Key& key) const {
+        unsigned h = hash_of(key);
+        for (index i = buckets[h & (bucket_count - 1)]; i != NIL;
+             i = slots[i].chain)
+            if (slots[i].hash == h && eq(slots[i].value().first, key))
+                return i;
+        return NIL;
+    }
+    void destroy_all() {
+        for (index i = head; i != NIL; i = slots[i].next)
+            slots[i].value().~value_type();
+        head = tail = free_head = NIL;
+        used = elements = 0;
+    }
+    void init(size_t capacity) {
+        slot_capacity = capacity;
+        slots = make_slots(capacity);
+        used = elements = 0;
+        head = tail = free_head = NIL;
+        size_t n = 1;
+        while (n * 3 < capacity * 4)
+            n *= 2;
+        make_buckets(n);
+    }
+
+   public:
+    compact_linked_hashmap() { init(CAPACITY_DEFAULT); }
+    explicit compact_linked_hashmap(const Alloc& a) : alloc(a) {
+        init(CAPACITY_DEFAULT);
+    }
+    compact_linked_hashmap(const compact_linked_hashmap& other)
+        : alloc(other.alloc) {
+        init(other.elements > CAPACITY_DEFAULT ? other.elements
+                                               : CAPACITY_DEFAULT);
+        for (index i = other.head; i != NIL; i = other.slots[i].next)
+            insert(other.slots[i].value());
+    }
+    compact_linked_hashmap& operator=(const compact_linked_hashmap& other) {
+        if (this == &other)
+            return *this;
+        clear();
+        reserve(other.elements);
+        for (index i = other.head; i != NIL; i = other.slots[i].next)
+            insert(other.slots[i].value());
+        return *this;
+    }
+    ~compact_linked_hashmap() {
+        destroy_all();
+        destroy_slots(slots, slot_capacity);
+        destroy_buckets();
+    }
+
+    class const_iterator;
+    class iterator {
+       public:
+        compact_linked_hashmap* map;
+        // NIL is end()
+        index at;
+
+        iterator(compact_linked_hashmap* map = nullptr, index at = NIL)
+            : map(map), at(at) {}
+
+        iterator& operator++() {
+            if (at == NIL)
+                throw std::runtime_error("invalid iterator");
+            at = map->slots[at].next;
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator to_return(*this);
+            ++*this;
+            return to_return;
+        }
+        /**
+         * --end() is the last inserted element
+         */
+        iterator& operator--() {
+            index prev = at == NIL ? map->tail : map->slots[at].prev;
+            if (prev == NIL)
+                throw std::runtime_error("invalid iterator");
+            at = prev;
+            return *this;
+        }
+        iterator operator--(int) {
+            iterator to_return(*this);
+            --*this;
+            return to_return;
+        }
+
+        value_type& operator*() const {
+            if (!map || at == NIL)
+                throw std::runtime_error("invalid iterator");
+            return map->slots[at].value();
+        }
+        value_type* operator->() const noexcept {
+            return &map->slots[at].value();
+        }
+
+        bool operator==(const iterator& rhs) const { return at == rhs.at; }
+        bool operator!=(const iterator& rhs) const { return at != rhs.at; }
+        bool operator==(const const_iterator& rhs) const {
+            return at == rhs.at;
+        }
+        bool operator!=(const const_iterator& rhs) const {
+            return at != rhs.at;
+        }
+    };
+    class const_iterator {
+       public:
+        const compact_linked_hashmap* map;
+        index at;
+
+        const_iterator(const compact_linked_hashmap* map = nullptr,
+                       index at = NIL)
+            : map(map), at(at) {}
+        const_iterator(const iterator& other)
+            : map(other.map), at(other.at) {}
+
+        const_iterator& operator++() {
+            if (at == NIL)
+                throw std::runtime_error("invalid iterator");
+            at = map->slots[at].next;
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator to_return(*this);
+            ++*this;
+            return to_return;
+        }
+        const_iterator& operator--() {
+            index prev = at == NIL ? map->tail : map->slots[at].prev;
+            if (prev == NIL)
+                throw std::runtime_error("invalid iterator");
+            at = prev;
+            return *this;
+        }
+        const_iterator operator--(int) {
+            const_iterator to_return(*this);
+            --*this;
+            return to_return;
+        }
+
+        const value_type& operator*() const {
+            if (!map || at == NIL)
+                throw std::runtime_error("invalid iterator");
+            return map->slots[at].value();
+        }
+        const value_type* operator->() const noexcept {
+            return &map->slots[at].value();
+        }
+
+        bool operator==(const iterator& rhs) const { return at == rhs.at; }
+        bool operator!=(const iterator& rhs) const { return at != rhs.at; }
+        bool operator==(const const_iterator& rhs) const {
+            return at == rhs.at;
+        }
+        bool operator!=(const const_iterator& rhs) const {
+            return at != rhs.at;
+        }
+    };
+
+    /**
+     * from the first inserted element to the last
+     */
+    iterator begin() { return iterator(this, head); }
+    const_iterator cbegin() const { return const_iterator(this, head); }
+    iterator end() { return iterator(this, NIL); }
+    const_iterator cend() const { return const_iterator(this, NIL); }
+
+    size_t size() const { return elements; }
+    bool empty() const { return !elements; }
+    /**
+     * the slots allocated, entries fit in before the array grows
+     */
+    size_t capacity() const { return slot_capacity; }
+
+    /**
+     * drop every element, the arrays are kept
+     */
+    void clear() {
+        destroy_all();
+        for (size_t b = 0; b < bucket_count; b++)
+            buckets[b] = NIL;
+    }
+    /**
+     * make room for n elements, so that inserting them never grows
+     */
+    void reserve(size_t n) {
+        if (n > slot_capacity)
+            reallocate(n < NIL ? n : NIL);
+    }
+
+    /**
+     * as linked_hashmap::insert: a new key is added at the back and
+     * true returned; an existing key has its value updated, is moved
+     * to the back and false is returned
+     */
+    pair<iterator, bool> insert(const value_type& value) {
+        unsigned h = hash_of(value.first);
+        for (index i = buckets[h & (bucket_count - 1)]; i != NIL;
+             i = slots[i].chain)
+            if (slots[i].hash == h && eq(slots[i].value().first, value.first)) {
+                slots[i].value().second = value.second;
+                move_to_back(iterator(this, i));
+                return {iterator(this, i), false};
+            }
+        index i = take_slot();
+        try {
+            new (slots[i].storage) value_type(value);
+        } catch (...) {
+            slots[i].next = free_head;
+            free_head = i;
+            throw;
+        }
+        slots[i].hash = h;
+        index& bucket = buckets[h & (bucket_count - 1)];
+        slots[i].chain = bucket;
+        bucket = i;
+        link_back(i);
+        elements++;
+        return {iterator(this, i), true};
+    }
+    /**
+     * erase the element pointed by the iterator, throw on end()
+     */
+    void remove(iterator pos) {
+        if (pos.at == NIL)
+            throw std::runtime_error("invalid iterator");
+        index i = pos.at;
+        index* at = &buckets[slots[i].hash & (bucket_count - 1)];
+        while (*at != i)
+            at = &slots[*at].chain;
+        *at = slots[i].chain;
+        unlink(i);
+        slots[i].value().~value_type();
+        slots[i].next = free_head;
+        free_head = i;
+        elements--;
+    }
+    /**
+     * make the element the last inserted one without copying it
+     */
+    void move_to_back(iterator pos) {
+        if (pos.at == tail)
+            return;
+        unlink(pos.at);
+        link_back(pos.at);
+    }
+
+    iterator find(const Key& key) { return iterator(this, find_index(key)); }
+    const_iterator find(const Key& key) const {
+        return const_iterator(this, find_index(key));
+    }
+    /**
+     * 1 if key is in the map, 0 otherwise
+     */
+    size_t count(const Key& key) const { return find_index(key) != NIL; }
+
+    /**
+     * the value of key, throw if it is not in the map
+     */
+    T& at(const Key& key) {
+        index i = find_index(key);
+        if (i == NIL)
+            throw std::runtime_error("T& at");
+        return slots[i].value().second;
+    }
+    const T& at(const Key& key) const {
+        index i = find_index(key);
+        if (i == NIL)
+            throw std::runtime_error("const T& at");
+        return slots[i].value().second;
+    }
+    T& operator[](const Key& key) { return at(key); }
+    const T& operator[](const Key& key) const { return at(key); }
+
+    /**
+     * as hashmap::diagnostics(); node_bytes are the slots in use
+     */
+    table_diagnostics diagnostics() const {
+        table_diagnostics d{elements, bucket_count, {}, 0, 0, 0, 0, 0, 0};
+        size_t non_empty = 0, walked = 0;
+        for (size_t b = 0; b < bucket_count; b++) {
+            size_t len = 0;
+            for (index i = buckets[b]; i != NIL; i = slots[i].chain)
+                len++;
+            if (len >= d.chains.size())
+                d.chains.resize(len + 1, 0);
+            d.chains[len]++;
+            non_empty += len != 0;
+            walked += len * (len + 1) / 2;
+            if (len > d.max_chain)
+                d.max_chain = len;
+        }
+        d.mean_chain = non_empty ? double(elements) / non_empty : 0;
+        d.probes_hit = elements ? double(walked) / elements : 0;
+        d.probes_miss = bucket_count ? double(elements) / bucket_count : 0;
+        d.bucket_bytes = bucket_count * sizeof(index);
+        d.node_bytes = elements * sizeof(slot);
+        return d;
+    }
+};
+}  // namespace sjtu
+
+#endif
@@ -0,0 +1,217 @@
+#ifndef SJTU_EXPORT_HPP
+#define SJTU_EXPORT_HPP
+
+#include <charconv>
+#include <cstdio>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include "class-integer.hpp"
+#include "class-matrix.hpp"
+#include "serialize.hpp"
+
+namespace sjtu {
+/**
+ * collects what is written and passes it to the stream in large
+ * blocks, so a dump costs one write per block instead of a flush
+ * per entry
+ */
+class buffered_sink {
+    std::ostream& out;
+    std::string buffer;
+    size_t limit;
+
+   public:
+    explicit buffered_sink(std::ostream& out, size_t limit = 1 << 16)
+        : out(out), limit(limit) {
+        buffer.reserve(limit + 256);
+    }
+    buffered_sink(const buffered_sink&) = delete;
+    buffered_sink& operator=(const buffered_sink&) = delete;
+    ~buffered_sink() { flush(); }
+
+    void write(const char* data, size_t n) {
+        buffer.append(data, n);
+        if (buffer.size() >= limit)
+            drain();
+    }
+    void put(char c) {
+        buffer.push_back(c);
+        if (buffer.size() >= limit)
+            drain();
+    }
+    /**
+     * n bytes at the end of the buffer, to be filled by the caller
+     */
+    char* extend(size_t n) {
+        if (buffer.size() + n > limit)
+            drain();
+        size_t at = buffer.size();
+        buffer.resize(at + n);
+        return &buffer[at];
+    }
+    void drain() {
+        out.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+    void flush() {
+        drain();
+        out.flush();
+    }
+};
+
+/**
+ * write v as text, without going through the locale and the
+ * formatting state of a stream when the type allows it
+ */
+template <class T>
+typename std::enable_if<std::is_integral<T>::value>::type put_text(
+    buffered_sink& out,
+    const T& v) {
+    char text[24];
+    out.write(text, std::to_chars(text, text + sizeof(text), v).ptr - text);
+}
+template <class T>
+typename std::enable_if<std::is_floating_point<T>::value>::type put_text(
+    buffered_sink& out,
+    const T& v) {
+    char text[32];
+    out.write(text, std::snprintf(text, sizeof(text), "%.17g", double(v)));
+}
+inline void put_text(buffered_sink& out, const Integer& v) {
+    put_text(out, v.val);
+}
+inline void put_text(buffered_sink& out, const std::string& v) {
+    out.write(v.data(), v.size());
+}
+/**
+ * [a b; c d]
+ */
+template <class T>
+void put_text(buffered_sink& out, const Matrix<T>& v) {
+    out.put('[');
+    for (size_t i = 0; i < v.RowSize(); i++) {
+        if (i)
+            out.write("; ", 2);
+        for (size_t j = 0; j < v.ColSize(); j++) {
+            if (j)
+                out.put(' ');
+            put_text(out, v[i][j]);
+        }
+    }
+    out.put(']');
+}
+/**
+ * anything else goes through operator<<
+ */
+template <class T>
+typename std::enable_if<!std::is_arithmetic<T>::value>::type put_text(
+    buffered_sink& out,
+    const T& v) {
+    std::ostringstream text;
+    text << v;
+    const std::string& s = text.str();
+    out.write(s.data(), s.size());
+}
+
+/**
+ * a field of a csv record, strings are quoted when they have to be
+ */
+template <class T>
+void put_csv(buffered_sink& out, const T& v) {
+    put_text(out, v);
+}
+inline void put_csv(buffered_sink& out, const std::string& v) {
+    if (v.find_first_of(",\"\n\r") == std::string::npos) {
+        put_text(out, v);
+        return;
+    }
+    out.put('"');
+    for (char c : v) {
+        if (c == '"')
+            out.put('"');
+        out.put(c);
+    }
+    out.put('"');
+}
+/**
+ * rows, columns, then the elements row by row
+ */
+template <class T>
+void put_csv(buffered_sink& out, const Matrix<T>& v) {
+    put_text(out, v.RowSize());
+    out.put(',');
+    put_text(out, v.ColSize());
+    for (size_t i = 0; i < v.RowSize(); i++) {
+        for (size_t j = 0; j < v.ColSize(); j++) {
+            out.put(',');
+            put_text(out, v[i][j]);
+        }
+    }
+}
+
+/**
+ * the formats of a dump, each writes one entry to the sink
+ * text: key value, one entry per line
+ */
+struct text_format {
+    template <class Key, class Value>
+    void operator()(buffered_sink& out,
+                    const Key& key,
+                    const Value& value) const {
+        put_text(out, key);
+        out.put(' ');
+        put_text(out, value);
+        out.put('\n');
+    }
+};
+/**
+ * csv: one record per entry, the key then the fields of the value
+ */
+struct csv_format {
+    template <class Key, class Value>
+    void operator()(buffered_sink& out,
+                    const Key& key,
+                    const Value& value) const {
+        put_csv(out, key);
+        out.put(',');
+        put_csv(out, value);
+        out.write("\r\n", 2);
+    }
+};
+/**
+ * binary: u32 length + key bytes, u32 length + value bytes, the
+ * encoding of serializer<T>, the same as the entries of a snapshot
+ */
+struct binary_format {
+    template <class T>
+    static void put(buffered_sink& out, const T& v) {
+        unsigned len = serializer<T>::size(v);
+        char* at = out.extend(sizeof(len) + len);
+        std::memcpy(at, &len, sizeof(len));
+        serializer<T>::write(v, at + sizeof(len));
+    }
+    template <class Key, class Value>
+    void operator()(buffered_sink& out,
+                    const Key& key,
+                    const Value& value) const {
+        put(out, key);
+        put(out, value);
+    }
+};
+
+/**
+ * write every entry of cache (anything with for_each(f(key, value)))
+ * to os in the given format, in the order for_each visits them
+ */
+template <class Format, class Cache>
+void dump(Cache& cache, std::ostream& os, Format format = Format()) {
+    buffered_sink out(os);
+    cache.for_each([&out, &format](const auto& key, const auto& value) {
+        format(out, key, value);
+    });
+}
+}  // namespace sjtu
+
+#endif
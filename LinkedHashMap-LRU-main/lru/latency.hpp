@@ -0,0 +1,138 @@
+#ifndef SJTU_LATENCY_HPP
+#define SJTU_LATENCY_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+
+namespace sjtu {
+/**
+ * a log-bucketed (HDR style) histogram of latencies in nanoseconds
+ * every power of two is split into SUB buckets, so a recorded value
+ * is known within 1/SUB of itself whatever its size, in a fixed
+ * array and with O(1) recording
+ */
+class latency_histogram {
+   public:
+    static constexpr int SUB_BITS = 3;
+    static constexpr unsigned long long SUB = 1ull << SUB_BITS;
+    static constexpr size_t BUCKETS = (64 - SUB_BITS + 1) * SUB;
+
+   private:
+    unsigned long long counts[BUCKETS];
+    unsigned long long total;
+    unsigned long long sum;
+    unsigned long long largest;
+
+    static int log2(unsigned long long v) {
+#if defined(__GNUC__) || defined(__clang__)
+        return 63 - __builtin_clzll(v);
+#else
+        int bits = 0;
+        while (v >>= 1)
+            bits++;
+        return bits;
+#endif
+    }
+
+   public:
+    latency_histogram() { reset(); }
+
+    /**
+     * values below SUB have a bucket each; above, the bucket is
+     * the power of two and the SUB_BITS bits under the top one
+     */
+    static size_t bucket_of(unsigned long long ns) {
+        if (ns < SUB)
+            return ns;
+        int shift = log2(ns) - SUB_BITS;
+        return (shift + 1) * SUB + ((ns >> shift) & (SUB - 1));
+    }
+    /**
+     * the largest value that falls into bucket
+     */
+    static unsigned long long bucket_high(size_t bucket) {
+        if (bucket < SUB)
+            return bucket;
+        int shift = bucket / SUB - 1;
+        unsigned long long low = (SUB + bucket % SUB) << shift;
+        return low + (1ull << shift) - 1;
+    }
+
+    void record(unsigned long long ns) {
+        counts[bucket_of(ns)]++;
+        total++;
+        sum += ns;
+        if (ns > largest)
+            largest = ns;
+    }
+    void reset() {
+        for (size_t i = 0; i < BUCKETS; i++)
+            counts[i] = 0;
+        total = sum = largest = 0;
+    }
+
+    unsigned long long count() const { return total; }
+    unsigned long long max() const { return largest; }
+    double mean() const { return total ? double(sum) / total : 0; }
+    /**
+     * the value that a fraction q (e.g. 0.99) of the recorded ones
+     * do not exceed, as the top of its bucket; 0 if none recorded
+     */
+    unsigned long long percentile(double q) const {
+        if (!total)
+            return 0;
+        unsigned long long rank = q * total;
+        if (rank < q * total || !rank)
+            rank++;
+        unsigned long long seen = 0;
+        for (size_t i = 0; i < BUCKETS; i++) {
+            seen += counts[i];
+            if (seen >= rank) {
+                unsigned long long high = bucket_high(i);
+                return high < largest ? high : largest;
+            }
+        }
+        return largest;
+    }
+    /**
+     * count, mean, p50, p99, p999 and max on one line
+     */
+    void print(std::ostream& os) const {
+        os << "count " << count() << " mean " << mean() << " p50 "
+           << percentile(0.5) << " p99 " << percentile(0.99) << " p999 "
+           << percentile(0.999) << " max " << max() << '\n';
+    }
+};
+
+/**
+ * records the time from its construction to its destruction
+ */
+class latency_scope {
+    latency_histogram& histogram;
+    std::chrono::steady_clock::time_point start;
+
+   public:
+    explicit latency_scope(latency_histogram& histogram)
+        : histogram(histogram), start(std::chrono::steady_clock::now()) {}
+    latency_scope(const latency_scope&) = delete;
+    ~latency_scope() {
+        histogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - start)
+                             .count());
+    }
+};
+}  // namespace sjtu
+
+/**
+ * time the rest of the enclosing block into histogram when
+ * SJTU_LATENCY is defined; without it the histograms do not exist
+ * and this expands to nothing
+ */
+#ifdef SJTU_LATENCY
+#define SJTU_TIMED(histogram) sjtu::latency_scope sjtu_latency_scope_(histogram)
+#else
+#define SJTU_TIMED(histogram) ((void)0)
+#endif
+
+#endif
@@ -4,8 +4,27 @@
 #include "class-integer.hpp"
 #include "class-matrix.hpp"
 #include "exceptions.hpp"
+#include "latency.hpp"
+#include "serialize.hpp"
+#include "timer-wheel.hpp"
 #include "utility.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
 #define CAPACITY_DEFAULT 16
+#if defined(__GNUC__) || defined(__clang__)
+#define SJTU_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define SJTU_PREFETCH(addr) ((void)0)
+#endif
 class Hash {
    public:
     unsigned int operator()(Integer lhs) const {
@@ -20,10 +39,82 @@ class Equal {
     }
 };
 
+inline std::ostream& print_key(std::ostream& os, const Integer& key) {
+    return os << key.val;
+}
+
 namespace sjtu {
-template <class T>
-class double_list {
+template <class Key>
+std::ostream& print_key(std::ostream& os, const Key& key) {
+    return os << key;
+}
+
+/**
+ * the allocations of one container by category, kept only when
+ * SJTU_ALLOC_STATS is defined (everything reads 0 otherwise)
+ * values counts the value_type objects the nodes own, not memory
+ * the values allocate themselves (e.g. the rows of a Matrix)
+ */
+struct alloc_account {
+    enum category { buckets, order_nodes, chain_nodes, values, CATEGORIES };
+    struct counts {
+        unsigned long long allocations;
+        unsigned long long frees;
+        unsigned long long live_bytes;
+    };
+#ifdef SJTU_ALLOC_STATS
+    counts of[CATEGORIES] = {};
+
+    void allocated(category c, size_t bytes) {
+        of[c].allocations++;
+        of[c].live_bytes += bytes;
+    }
+    void freed(category c, size_t bytes) {
+        of[c].frees++;
+        of[c].live_bytes -= bytes;
+    }
+    counts get(category c) const { return of[c]; }
+    /**
+     * zero the allocations and frees, live_bytes stays
+     */
+    void reset() {
+        for (counts& c : of)
+            c.allocations = c.frees = 0;
+    }
+#else
+    void allocated(category, size_t) {}
+    void freed(category, size_t) {}
+    counts get(category) const { return counts{0, 0, 0}; }
+    void reset() {}
+#endif
+    counts total() const {
+        counts sum{0, 0, 0};
+        for (int c = 0; c < CATEGORIES; c++) {
+            counts one = get(category(c));
+            sum.allocations += one.allocations;
+            sum.frees += one.frees;
+            sum.live_bytes += one.live_bytes;
+        }
+        return sum;
+    }
+};
+
+/**
+ * the allocator of the same family for another type
+ */
+template <class Alloc, class T>
+using rebind_alloc =
+    typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+
+/**
+ * nodes and values come from Alloc (rebound to them); the allocator
+ * is a private base, so a stateless one takes no room in the
+ * bucket array
+ */
+template <class T, class Alloc = std::allocator<T>>
+class double_list : private rebind_alloc<Alloc, T> {
    public:
+    using allocator_type = rebind_alloc<Alloc, T>;
     class Node {
        public:
         T* val_ptr;
@@ -40,18 +131,82 @@ class double_list {
                 dual->dual = nullptr;
             }
             dual = nullptr;
-            if (val_ptr)
-                delete val_ptr;
         }
     };
+
+   private:
+    using node_allocator = rebind_alloc<Alloc, Node>;
+    using value_traits = std::allocator_traits<allocator_type>;
+    using node_traits = std::allocator_traits<node_allocator>;
+
+   public:
     Node* end_ptr;
     Node end_node;
     Node* head;
     size_t size;
+#ifdef SJTU_ALLOC_STATS
+    // set by the container owning the list
+    alloc_account* account = nullptr;
+    alloc_account::category category = alloc_account::chain_nodes;
+#endif
     // --------------------------
 
-    double_list() : size(0), end_node() { head = end_ptr = &end_node; }
-    double_list(const double_list<T>& other) : size(0), end_node() {
+    /**
+     * every node of the list is made and destroyed here
+     */
+    Node* make_node(const T& val) {
+#ifdef SJTU_ALLOC_STATS
+        if (account) {
+            account->allocated(category, sizeof(Node));
+            account->allocated(alloc_account::values, sizeof(T));
+        }
+#endif
+        allocator_type& values = *this;
+        node_allocator nodes(values);
+        // both blocks first, so only a constructed value is destroyed
+        T* value = value_traits::allocate(values, 1);
+        Node* node;
+        try {
+            node = node_traits::allocate(nodes, 1);
+        } catch (...) {
+            value_traits::deallocate(values, value, 1);
+            throw;
+        }
+        try {
+            value_traits::construct(values, value, val);
+        } catch (...) {
+            node_traits::deallocate(nodes, node, 1);
+            value_traits::deallocate(values, value, 1);
+            throw;
+        }
+        node_traits::construct(nodes, node, value);
+        return node;
+    }
+    void destroy_node(Node* node) {
+#ifdef SJTU_ALLOC_STATS
+        if (account) {
+            account->freed(category, sizeof(Node));
+            if (node->val_ptr)
+                account->freed(alloc_account::values, sizeof(T));
+        }
+#endif
+        allocator_type& values = *this;
+        if (node->val_ptr) {
+            value_traits::destroy(values, node->val_ptr);
+            value_traits::deallocate(values, node->val_ptr, 1);
+        }
+        node_allocator nodes(values);
+        node_traits::destroy(nodes, node);
+        node_traits::deallocate(nodes, node, 1);
+    }
+    allocator_type get_allocator() const { return *this; }
+
+    explicit double_list(const Alloc& alloc = Alloc())
+        : allocator_type(alloc), size(0), end_node() {
+        head = end_ptr = &end_node;
+    }
+    double_list(const double_list& other)
+        : allocator_type(other.get_allocator()), size(0), end_node() {
         head = end_ptr = &end_node;
         *this = other;
     }
@@ -151,13 +306,13 @@ class double_list {
         (to_delete->next)->prev = to_delete->prev;
         if (to_delete->dual)
             to_delete->dual->dual = nullptr;
-        delete to_delete;
+        destroy_node(to_delete);
         size--;
         return iterator(to_return);
     }
     void insert_head(const T& val) {
         // modify head
-        Node* node_ptr = new Node(new T(val));
+        Node* node_ptr = make_node(val);
         if (head == end_ptr) {
             head = node_ptr;
             node_ptr->next = end_ptr;
@@ -170,7 +325,7 @@ class double_list {
     }
     void insert_tail(const T& val) {
         // modify head
-        Node* node_ptr = new Node(new T(val));
+        Node* node_ptr = make_node(val);
         if (end_ptr != head) {
             end_ptr->prev->next = node_ptr;
             node_ptr->prev = end_ptr->prev;
@@ -192,9 +347,27 @@ class double_list {
             to_delete->dual->dual = nullptr;
         head = head->next;
         head->prev = nullptr;
-        delete to_delete;
+        destroy_node(to_delete);
         size--;
     }
+    /**
+     * relink a node of this list just before end, nothing is copied
+     */
+    void move_to_tail(Node* node) {
+        if (node == end_ptr || node == end_ptr->prev)
+            return;
+        if (node == head) {
+            head = node->next;
+            head->prev = nullptr;
+        } else {
+            node->prev->next = node->next;
+            node->next->prev = node->prev;
+        }
+        node->prev = end_ptr->prev;
+        node->next = end_ptr;
+        end_ptr->prev->next = node;
+        end_ptr->prev = node;
+    }
     void delete_tail() {
         // modify head
         if (head == end_ptr)
@@ -206,7 +379,7 @@ class double_list {
             to_delete->prev->next = end_ptr;
         else
             head = end_ptr;
-        delete to_delete;
+        destroy_node(to_delete);
         size--;
     }
     void clear() {
@@ -217,10 +390,11 @@ class double_list {
             if (to_delete->dual)
                 to_delete->dual->dual = nullptr;
             current = current->next;
-            delete to_delete;
+            destroy_node(to_delete);
         }
 
         head = end_ptr = &end_node;
+        size = 0;
     }
     /**
      * if didn't contain anything, return true,
@@ -229,37 +403,134 @@ class double_list {
     bool empty() { return !size; }
 };
 
+/**
+ * spread every bit of a hash over the result (the splitmix64
+ * finalizer), for tables that take a bucket from the low bits with
+ * a mask: an identity hash of keys with a power-of-two stride would
+ * otherwise fill a single bucket
+ */
+inline unsigned mix_hash(unsigned long long h) {
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebull;
+    return unsigned(h ^ (h >> 31));
+}
+
+/**
+ * how well a hashmap spreads its keys, from hashmap::diagnostics()
+ * chains[k] is the number of buckets holding k nodes. a successful
+ * find walks to its node, probes_hit is the mean length of that
+ * walk; an unsuccessful one walks a whole chain, probes_miss is the
+ * mean chain length over all buckets (a key hashing uniformly).
+ * the bytes are those of the table itself, not of memory the keys
+ * or values own
+ */
+struct table_diagnostics {
+    size_t size;
+    size_t capacity;
+    std::vector<size_t> chains;
+    size_t max_chain;
+    // over the buckets holding at least one node
+    double mean_chain;
+    double probes_hit;
+    double probes_miss;
+    size_t bucket_bytes;
+    size_t node_bytes;
+
+    double load_factor() const {
+        return capacity ? double(size) / capacity : 0;
+    }
+    void print(std::ostream& os) const {
+        os << "size " << size << " capacity " << capacity << " load "
+           << load_factor() << '\n';
+        os << "chain max " << max_chain << " mean " << mean_chain
+           << " probes hit " << probes_hit << " miss " << probes_miss << '\n';
+        os << "bytes buckets " << bucket_bytes << " nodes " << node_bytes
+           << '\n';
+        for (size_t k = 0; k < chains.size(); k++)
+            if (chains[k])
+                os << k << ": " << chains[k] << '\n';
+    }
+};
+
 template <class Key,
           class T,
           class Hash = std::hash<Key>,
-          class Equal = std::equal_to<Key>>
+          class Equal = std::equal_to<Key>,
+          class Alloc = std::allocator<pair<const Key, T>>>
 class hashmap {
    public:
     using value_type = pair<const Key, T>;
-    using Node = typename double_list<value_type>::Node;
-    using list = double_list<value_type>;
+    using allocator_type = rebind_alloc<Alloc, value_type>;
+    using list = double_list<value_type, allocator_type>;
+    using Node = typename list::Node;
     list* buckets;
     // using the heap space
     Hash hash;
     Equal eq;
+    // the buckets, and through them every node, are allocated by it
+    allocator_type alloc;
     size_t size;
     size_t capacity;
     const float loadFactor = 0.75;
+#ifdef SJTU_LATENCY
+    latency_histogram expand_latency;
+#endif
 
     // --------------------------
 
-    hashmap(size_t _capacity = CAPACITY_DEFAULT)
-        : size(0), capacity(_capacity) {
-        buckets = new list[_capacity];
+#ifdef SJTU_ALLOC_STATS
+    // where the allocations are counted: allocations, or the account
+    // of the map a temporary one is rehashed for
+    alloc_account allocations;
+    alloc_account* account = &allocations;
+#endif
+
+    /**
+     * every bucket array is made and destroyed here
+     */
+    list* make_buckets(size_t n) {
+        rebind_alloc<Alloc, list> lists(alloc);
+        list* made = std::allocator_traits<decltype(lists)>::allocate(lists, n);
+        for (size_t i = 0; i < n; i++)
+            new (made + i) list(alloc);
+#ifdef SJTU_ALLOC_STATS
+        account->allocated(alloc_account::buckets, n * sizeof(list));
+        for (size_t i = 0; i < n; i++)
+            made[i].account = account;
+#endif
+        return made;
+    }
+    void destroy_buckets() {
+#ifdef SJTU_ALLOC_STATS
+        account->freed(alloc_account::buckets, capacity * sizeof(list));
+#endif
+        for (size_t i = 0; i < capacity; i++)
+            buckets[i].~list();
+        rebind_alloc<Alloc, list> lists(alloc);
+        std::allocator_traits<decltype(lists)>::deallocate(lists, buckets,
+                                                           capacity);
+    }
+
+    hashmap(size_t _capacity = CAPACITY_DEFAULT, const Alloc& a = Alloc())
+        : alloc(a), size(0), capacity(_capacity) {
+        buckets = make_buckets(_capacity);
+    }
+#ifdef SJTU_ALLOC_STATS
+    hashmap(size_t _capacity, const Alloc& a, alloc_account* shared)
+        : alloc(a), size(0), capacity(_capacity), account(shared) {
+        buckets = make_buckets(_capacity);
     }
+#endif
     void resize(list*& _buckets, size_t _capacity) {
         // I need to thank Zhangrenhao for reminding me the '&'
         // the delete operation is done in (total_)clear
-        _buckets = new list[_capacity];
+        _buckets = make_buckets(_capacity);
     }
-    hashmap(const hashmap& other) {
+    hashmap(const hashmap& other) : alloc(other.alloc) {
         capacity = other.capacity;
-        buckets = new list[capacity];
+        buckets = make_buckets(capacity);
         for (int i = 0; i < capacity; i++)
             buckets[i] = other.buckets[i];
         size = other.size;
@@ -273,7 +544,7 @@ class hashmap {
         size = 0;
     }
     void total_clear() {
-        delete[] buckets;
+        destroy_buckets();
         size = 0;
     }
     hashmap& operator=(const hashmap& other) {
@@ -322,7 +593,58 @@ class hashmap {
      * you need to expand the hashmap dynamically
      */
     void expand() {
-        hashmap new_map(capacity * 2);
+        SJTU_TIMED(expand_latency);
+        rehash(capacity * 2);
+    }
+    /**
+     * make room for n elements, so that inserting them never expands
+     */
+    void reserve(size_t n) {
+        size_t wanted = 4 * n / 3 + 5;
+        if (wanted <= capacity)
+            return;
+        if (size) {
+            rehash(wanted);
+            return;
+        }
+        destroy_buckets();
+        capacity = wanted;
+        resize(buckets, capacity);
+    }
+    /**
+     * walk every bucket once, O(size + capacity)
+     */
+    table_diagnostics diagnostics() const {
+        table_diagnostics d{size, capacity, {}, 0, 0, 0, 0, 0, 0};
+        size_t used = 0, walked = 0;
+        for (size_t i = 0; i < capacity; i++) {
+            size_t len = 0;
+            for (Node* n = buckets[i].head; n != buckets[i].end_ptr;
+                 n = n->next)
+                len++;
+            if (len >= d.chains.size())
+                d.chains.resize(len + 1, 0);
+            d.chains[len]++;
+            used += len != 0;
+            // the k-th node of a chain is found after k probes
+            walked += len * (len + 1) / 2;
+            if (len > d.max_chain)
+                d.max_chain = len;
+        }
+        d.mean_chain = used ? double(size) / used : 0;
+        d.probes_hit = size ? double(walked) / size : 0;
+        d.probes_miss = capacity ? double(size) / capacity : 0;
+        d.bucket_bytes = capacity * sizeof(list);
+        d.node_bytes = size * (sizeof(Node) + sizeof(value_type));
+        return d;
+    }
+    void rehash(size_t new_capacity) {
+#ifdef SJTU_ALLOC_STATS
+        // the copies made for the new table count as this map's
+        hashmap new_map(new_capacity, alloc, account);
+#else
+        hashmap new_map(new_capacity, alloc);
+#endif
         for (int i = 0; i < capacity; i++) {
             for (auto iter = buckets[i].begin(); iter != buckets[i].end();
                  iter++) {
@@ -333,7 +655,9 @@ class hashmap {
                 iter.ptr->dual = nullptr;
             }
         }
-        *this = new_map;
+        // take the new buckets, new_map frees the old ones
+        std::swap(buckets, new_map.buckets);
+        std::swap(capacity, new_map.capacity);
     }
 
     /**
@@ -345,7 +669,13 @@ class hashmap {
      * not find, return the end (point to nothing)
      */
     iterator find(const Key& key) const {
-        int index = hash(key) % capacity;
+        return find_hashed(bucket_of(key), key);
+    }
+    size_t bucket_of(const Key& key) const { return hash(key) % capacity; }
+    /**
+     * find with the bucket already known (from bucket_of)
+     */
+    iterator find_hashed(size_t index, const Key& key) const {
         Node* elem = buckets[index].head;
         while (elem != buckets[index].end_ptr) {
             if (elem->val_ptr) {
@@ -356,6 +686,20 @@ class hashmap {
         }
         return iterator(nullptr);
     }
+    /**
+     * hints for batched lookups, each stage reads only what the
+     * previous one brought in: the bucket, then its first node,
+     * then the value and the dual of that node
+     */
+    void prefetch_bucket(size_t index) const { SJTU_PREFETCH(buckets + index); }
+    void prefetch_node(size_t index) const {
+        SJTU_PREFETCH(buckets[index].head);
+    }
+    void prefetch_value(size_t index) const {
+        Node* first = buckets[index].head;
+        SJTU_PREFETCH(first->val_ptr);
+        SJTU_PREFETCH(first->dual);
+    }
     /**
      * already have a value_pair with the same key
      * -> just update the value, return false
@@ -379,7 +723,7 @@ class hashmap {
      * the value_pair exists, remove and return true
      * otherwise, return false
      */
-    using Node_iterator = typename sjtu::double_list<value_type>::iterator;
+    using Node_iterator = typename list::iterator;
     bool remove(const Key& key) {
         auto iter = find(key);
         int index = hash(key) % capacity;
@@ -394,36 +738,58 @@ class hashmap {
 template <class Key,
           class T,
           class Hash = std::hash<Key>,
-          class Equal = std::equal_to<Key>>
-class linked_hashmap : public hashmap<Key, T, Hash, Equal> {
+          class Equal = std::equal_to<Key>,
+          class Alloc = std::allocator<pair<const Key, T>>>
+class linked_hashmap : public hashmap<Key, T, Hash, Equal, Alloc> {
    public:
     typedef pair<const Key, T> value_type;
-    using Node = typename double_list<value_type>::Node;
-    double_list<value_type> history;
+    using list = typename hashmap<Key, T, Hash, Equal, Alloc>::list;
+    using Node = typename list::Node;
+    list history;
+#ifdef SJTU_LATENCY
+    latency_histogram remove_latency;
+#endif
     //  --------------------------
 
-    linked_hashmap() {}
-    linked_hashmap(const linked_hashmap& other) { *this = other; }
+    linked_hashmap() { count_history(); }
+    explicit linked_hashmap(const Alloc& alloc)
+        : hashmap<Key, T, Hash, Equal, Alloc>(CAPACITY_DEFAULT, alloc),
+          history(alloc) {
+        count_history();
+    }
+    linked_hashmap(const linked_hashmap& other)
+        : hashmap<Key, T, Hash, Equal, Alloc>(CAPACITY_DEFAULT, other.alloc),
+          history(other.alloc) {
+        count_history();
+        *this = other;
+    }
     ~linked_hashmap() {}
     linked_hashmap& operator=(const linked_hashmap& other) {
         if (this == &other)
             return *this;
-        this->hashmap<Key, T, Hash, Equal>::total_clear();
+        this->hashmap<Key, T, Hash, Equal, Alloc>::total_clear();
         history.clear();
         this->capacity = other.capacity;
         this->resize(this->buckets, this->capacity);
         for (auto iter = other.history.begin(); iter != other.history.end();
              iter++) {
             history.insert_tail(*(iter.ptr->val_ptr));
-            auto _iter =
-                hashmap<Key, T, Hash, Equal>::insert(*(iter.ptr->val_ptr))
-                    .first;
+            auto _iter = hashmap<Key, T, Hash, Equal, Alloc>::insert(
+                             *(iter.ptr->val_ptr))
+                             .first;
             history.end_ptr->prev->dual = _iter.ptr;
             _iter.ptr->dual = history.end_ptr->prev;
         }
         return *this;
     }
 
+    void count_history() {
+#ifdef SJTU_ALLOC_STATS
+        history.account = this->account;
+        history.category = alloc_account::order_nodes;
+#endif
+    }
+
     /**
      * return the value connected with the Key(O(1))
      * if the key not found, throw
@@ -634,7 +1000,7 @@ class linked_hashmap : public hashmap<Key, T, Hash, Equal> {
     bool empty() const { return !this->size(); }
 
     void clear() {
-        hashmap<Key, T, Hash, Equal>::clear();
+        hashmap<Key, T, Hash, Equal, Alloc>::clear();
         history.clear();
     }
 
@@ -652,7 +1018,8 @@ class linked_hashmap : public hashmap<Key, T, Hash, Equal> {
     pair<iterator, bool> insert(const value_type& value) {
         // everytime you insert
         // it means "push_back" (not "push_front")
-        auto iter = this->hashmap<Key, T, Hash, Equal>::find(value.first);
+        auto iter =
+            this->hashmap<Key, T, Hash, Equal, Alloc>::find(value.first);
         // the iter is on the hashmap(buckets)
         if (iter.ptr) {
             // it implies that key already exists.
@@ -665,7 +1032,8 @@ class linked_hashmap : public hashmap<Key, T, Hash, Equal> {
         }
         history.insert_tail(value);
         auto to_return = iterator(history.end_ptr->prev);
-        auto to_add = (this->hashmap<Key, T, Hash, Equal>::insert(value)).first;
+        auto to_add =
+            (this->hashmap<Key, T, Hash, Equal, Alloc>::insert(value)).first;
         // problem: when the hashmap expand,
         // the dual isn't maintained
         to_return.ptr->dual = to_add.ptr;
@@ -677,24 +1045,46 @@ class linked_hashmap : public hashmap<Key, T, Hash, Equal> {
      * if the iterator points to nothing
      * throw
      */
-    using Node_iterator = typename sjtu::double_list<value_type>::iterator;
+    using Node_iterator = typename list::iterator;
     void remove(iterator pos) {
         if (!pos.ptr || !pos.ptr->val_ptr) {
             throw std::runtime_error("676:void remove");
         }
+        SJTU_TIMED(remove_latency);
+        // the bucket node is reached through dual, no search needed
         Node* to_delete = pos.ptr;
-        Key key = pos.ptr->val_ptr->first;
+        size_t index = this->bucket_of(to_delete->val_ptr->first);
+        this->buckets[index].erase(Node_iterator(to_delete->dual));
+        this->hashmap<Key, T, Hash, Equal, Alloc>::size--;
         history.erase(Node_iterator(to_delete));
-        this->hashmap<Key, T, Hash, Equal>::remove(key);
         return;
     }
 
+    /**
+     * as hashmap::diagnostics(), the nodes of the history counted too
+     */
+    table_diagnostics diagnostics() const {
+        table_diagnostics d =
+            this->hashmap<Key, T, Hash, Equal, Alloc>::diagnostics();
+        d.node_bytes *= 2;
+        return d;
+    }
+    /**
+     * make the element the last inserted one without copying it
+     */
+    void move_to_back(iterator pos) { history.move_to_tail(pos.ptr); }
+    /**
+     * the bucket node keeps the copy of the value made on insertion,
+     * which nothing reads; reset it to T() to give its memory back
+     */
+    void release_shadow(iterator pos) { pos.ptr->dual->val_ptr->second = T(); }
+
     /**
      * return how many value_pairs consist of key
      * this should only return 0 or 1
      */
     size_t count(const Key& key) const {
-        auto iter = hashmap<Key, T, Hash, Equal>::find(key);
+        auto iter = hashmap<Key, T, Hash, Equal, Alloc>::find(key);
         if (!iter.ptr)
             return 0;
         return 1;
@@ -706,50 +1096,1136 @@ class linked_hashmap : public hashmap<Key, T, Hash, Equal> {
      * point at nothing
      */
     iterator find(const Key& key) {
-        auto iter = this->hashmap<Key, T, Hash, Equal>::find(key);
+        auto iter = this->hashmap<Key, T, Hash, Equal, Alloc>::find(key);
+        if (iter.ptr)
+            return iterator(iter.ptr->dual);
+        return end();
+    }
+    iterator find_hashed(size_t index, const Key& key) {
+        auto iter = this->hashmap<Key, T, Hash, Equal, Alloc>::find_hashed(
+            index, key);
         if (iter.ptr)
             return iterator(iter.ptr->dual);
         return end();
     }
 };
 
-class lru {
-    using lmap = sjtu::linked_hashmap<Integer, Matrix<int>, Hash, Equal>;
-    using value_type = sjtu::pair<const Integer, Matrix<int>>;
-    using Node = typename double_list<value_type>::Node;
-    using Node_iterator = typename double_list<value_type>::iterator;
+/**
+ * how heavy a cached value is, by default its own size
+ * a matrix weighs the bytes of its elements
+ */
+template <class Value>
+struct value_weight {
+    static size_t of(const Value&) { return sizeof(Value); }
+};
+template <class T>
+struct value_weight<Matrix<T>> {
+    static size_t of(const Matrix<T>& value) {
+        return value.RowSize() * value.ColSize() * sizeof(T);
+    }
+};
+template <class Key, class Value>
+size_t default_weight(const Key&, const Value& value) {
+    return value_weight<Value>::of(value);
+}
+
+/**
+ * any callable weigh(key, value) returning size_t: a function, a
+ * lambda capturing what it needs or a functor with state. a copy
+ * copies the callable (<functional> pulls in the hash containers,
+ * so std::function is not used)
+ */
+template <class Key, class Value>
+class weight_function {
+    struct callable {
+        virtual size_t call(const Key& key, const Value& value) = 0;
+        virtual callable* clone() const = 0;
+        virtual ~callable() {}
+    };
+    template <class F>
+    struct holder : callable {
+        F f;
+        explicit holder(const F& f) : f(f) {}
+        size_t call(const Key& key, const Value& value) override {
+            return f(key, value);
+        }
+        callable* clone() const override { return new holder(f); }
+    };
+    callable* fn;
+
+   public:
+    template <class F,
+              class = typename std::enable_if<!std::is_same<
+                  typename std::decay<F>::type,
+                  weight_function>::value>::type>
+    weight_function(const F& f)
+        : fn(new holder<typename std::decay<F>::type>(f)) {}
+    weight_function(const weight_function& other) : fn(other.fn->clone()) {}
+    weight_function& operator=(const weight_function& other) {
+        if (this != &other) {
+            callable* copy = other.fn->clone();
+            delete fn;
+            fn = copy;
+        }
+        return *this;
+    }
+    ~weight_function() { delete fn; }
+
+    size_t operator()(const Key& key, const Value& value) const {
+        return fn->call(key, value);
+    }
+};
+
+/**
+ * small trivially copyable keys and values are passed by value
+ */
+template <class T>
+using param_type =
+    typename std::conditional<std::is_trivially_copyable<T>::value &&
+                                  sizeof(T) <= 2 * sizeof(void*),
+                              T,
+                              const T&>::type;
+
+/**
+ * told about the accesses of a cache, e.g. to record a trace
+ * hit and miss are the two outcomes of a get
+ */
+template <class Key>
+class access_observer {
+   public:
+    enum event { save, hit, miss, evict };
+    virtual void on_access(event e, const Key& key) = 0;
+    virtual ~access_observer() {}
+};
+
+/**
+ * hands every access to several observers in turn, for a cache that
+ * is traced and estimated at once: cache.set_observer(&fan)
+ */
+template <class Key>
+class observer_fan : public access_observer<Key> {
+    std::vector<access_observer<Key>*> targets;
+
+   public:
+    observer_fan(std::initializer_list<access_observer<Key>*> list = {})
+        : targets(list) {}
+    void add(access_observer<Key>* o) { targets.push_back(o); }
+    void remove(access_observer<Key>* o) {
+        for (size_t i = 0; i < targets.size(); i++)
+            if (targets[i] == o) {
+                targets.erase(targets.begin() + i);
+                return;
+            }
+    }
+    void on_access(typename access_observer<Key>::event e,
+                   const Key& key) override {
+        for (access_observer<Key>* o : targets)
+            o->on_access(e, key);
+    }
+};
+
+/**
+ * the counters of a cache at one moment, and its size and weight
+ * load_successes/load_failures count the loader calls of get_or_load
+ */
+struct cache_stats {
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long inserts;
+    unsigned long long updates;
+    unsigned long long evictions;
+    unsigned long long load_successes;
+    unsigned long long load_failures;
+    size_t size;
+    size_t weight;
+
+    double hit_ratio() const {
+        return hits + misses ? double(hits) / (hits + misses) : 0;
+    }
+};
+
+/**
+ * the event counters of a basic_lru, all 0 and free of cost when
+ * SJTU_NO_STATS is defined
+ * every counter has one writer at a time (the cache is not shared
+ * without a lock), so an increment is a relaxed load and store with
+ * no locked instruction; any thread may read them meanwhile
+ */
+class stat_counters {
+   public:
+    enum counter {
+        hits,
+        misses,
+        inserts,
+        updates,
+        evictions,
+        load_successes,
+        load_failures,
+        COUNTERS
+    };
+#ifndef SJTU_NO_STATS
+    stat_counters() { reset(); }
+    void add(counter c, unsigned long long n = 1) {
+        values[c].store(values[c].load(std::memory_order_relaxed) + n,
+                        std::memory_order_relaxed);
+    }
+    unsigned long long get(counter c) const {
+        return values[c].load(std::memory_order_relaxed);
+    }
+    void reset() {
+        for (auto& value : values)
+            value.store(0, std::memory_order_relaxed);
+    }
+
+   private:
+    std::atomic<unsigned long long> values[COUNTERS];
+#else
+    void add(counter, unsigned long long = 1) {}
+    unsigned long long get(counter) const { return 0; }
+    void reset() {}
+#endif
+};
+
+/**
+ * a second level behind a basic_lru: evicted entries are put into
+ * it, and a get missing the cache takes the entry back from it
+ */
+template <class Key, class Value>
+class victim_tier {
+   public:
+    virtual void put(const Key& key, const Value& value) = 0;
+    /**
+     * the value of key, removed from the tier; nullptr if none
+     */
+    virtual std::unique_ptr<Value> take(const Key& key) = 0;
+    /**
+     * forget key, the cache has a newer value
+     */
+    virtual void erase(const Key& key) = 0;
+    virtual ~victim_tier() {}
+};
+
+template <class Key,
+          class Value,
+          class Hash = std::hash<Key>,
+          class Equal = std::equal_to<Key>,
+          class Alloc = std::allocator<pair<const Key, Value>>>
+class basic_lru {
+   public:
+    using key_arg = param_type<Key>;
+    using value_arg = param_type<Value>;
+    using value_type = sjtu::pair<const Key, Value>;
+    using allocator_type = Alloc;
+    using weigher = weight_function<Key, Value>;
+    static constexpr unsigned long long NEVER = ~0ull;
+
+   private:
+    using wheel = timer_wheel<Key>;
+    using timer = typename wheel::timer;
+    /**
+     * the weight is kept next to the value, so a value changed
+     * through the pointer returned by get() is still released
+     * with the weight it was charged
+     * expiry is the timer of the entry, nullptr if it never expires
+     */
+    struct entry {
+        Value value;
+        size_t weight;
+        timer* expiry;
+        unsigned long long write_deadline;
+        // the compressed value of a cold entry, value is then empty
+        std::string* packed;
+    };
+    // the table takes Alloc rebound to its entries
+    using entry_alloc = rebind_alloc<Alloc, pair<const Key, entry>>;
+    using lmap = sjtu::linked_hashmap<Key, entry, Hash, Equal, entry_alloc>;
+    using iterator = typename lmap::iterator;
+    // what save(key, value) hands to store(), nothing copied
+    struct arg_pair {
+        key_arg first;
+        value_arg second;
+    };
     lmap map;
     size_t max_size;
+    size_t max_weight;
+    // once over max_size or max_weight, evict down to these
+    size_t low_size;
+    size_t low_weight;
+    size_t total_weight;
+    weigher weigh;
+    wheel timers;
+    ttl_clock* clock;
+    access_observer<Key>* observer;
+    victim_tier<Key, Value>* tier;
+    stat_counters counters;
+#ifdef SJTU_LATENCY
+    latency_histogram save_histogram;
+    latency_histogram get_histogram;
+#endif
+    // with hot_fraction < 1 the entries are in two zones: the most
+    // recent hot_limit() keep plain values, the older ones (toward
+    // the head) are compressed; boundary is the oldest hot entry
+    double hot_fraction;
+    size_t hot_count;
+    iterator boundary;
+    unsigned long long write_ttl;
+    unsigned long long access_ttl;
+    /**
+     * a load in progress, shared by the caller running the loader
+     * and every caller waiting for it
+     */
+    struct flight {
+        std::condition_variable finished;
+        bool done = false;
+        size_t waiters = 0;
+        Value* result = nullptr;
+        std::exception_ptr error;
+        ~flight() { delete result; }
+    };
+    std::mutex flight_lock;
+    linked_hashmap<Key, flight*, Hash, Equal> flights;
+
+    void erase(iterator iter) {
+        total_weight -= iter->second.weight;
+        if (iter->second.expiry)
+            timers.cancel(iter->second.expiry);
+        if (iter->second.packed)
+            delete iter->second.packed;
+        else if (zoned())
+            hot_count--;
+        if (iter == boundary)
+            ++boundary;
+        map.remove(iter);
+    }
+    /**
+     * victim leaves the cache: counted, reported, handed to the tier
+     */
+    void evict(iterator victim) {
+        counters.add(stat_counters::evictions);
+        notify(access_observer<Key>::evict, victim->first);
+        if (tier)
+            with_value(victim, [this, victim](const Value& value) {
+                tier->put(victim->first, value);
+            });
+        erase(victim);
+    }
+    void evict() { evict(map.begin()); }
+    /**
+     * f(the plain value of iter), unpacked into a temporary if cold
+     */
+    template <class F>
+    void with_value(iterator iter, F&& f) {
+        if constexpr (value_codec<Value>::enabled) {
+            if (iter->second.packed) {
+                const Value plain =
+                    value_codec<Value>::unpack(*iter->second.packed);
+                f(plain);
+                return;
+            }
+        }
+        f(static_cast<const Value&>(iter->second.value));
+    }
+
+    bool zoned() const { return hot_fraction < 1; }
+    size_t hot_limit() const {
+        size_t limit = hot_fraction * max_size;
+        return limit ? limit : 1;
+    }
+    /**
+     * compress the oldest hot entries until the hot zone fits,
+     * a cold entry weighs its compressed bytes
+     */
+    void cool() {
+        if constexpr (value_codec<Value>::enabled) {
+            while (hot_count > hot_limit()) {
+                entry& e = boundary->second;
+                e.packed = new std::string;
+                value_codec<Value>::pack(e.value, *e.packed);
+                e.value = Value();
+                map.release_shadow(boundary);
+                total_weight -= e.weight;
+                e.weight = e.packed->size();
+                total_weight += e.weight;
+                ++boundary;
+                hot_count--;
+            }
+        }
+    }
+    /**
+     * iter is about to become the most recent entry: a cold entry
+     * turns hot (unpacked if restore, else its value is about to be
+     * replaced), a hot one at the boundary moves the boundary on
+     */
+    void heat(iterator iter, bool restore) {
+        entry& e = iter->second;
+        if (e.packed) {
+            if constexpr (value_codec<Value>::enabled) {
+                if (restore) {
+                    e.value = value_codec<Value>::unpack(*e.packed);
+                    total_weight -= e.weight;
+                    e.weight = weigh(iter->first, e.value);
+                    total_weight += e.weight;
+                }
+            }
+            delete e.packed;
+            e.packed = nullptr;
+            hot_count++;
+            if (boundary == map.end())
+                boundary = iter;
+        } else if (iter == boundary) {
+            ++boundary;
+            if (boundary == map.end())
+                boundary = iter;
+        }
+    }
+    /**
+     * delete the compressed values; restore: unpack them first
+     */
+    void drop_packed(bool restore) {
+        for (iterator it = map.begin(); it != map.end(); it++) {
+            if (!it->second.packed)
+                continue;
+            if (restore)
+                heat(it, true);
+            else
+                delete it->second.packed;
+        }
+    }
+    void notify(typename access_observer<Key>::event e, const Key& key) {
+        if (observer)
+            observer->on_access(e, key);
+    }
+    /**
+     * evict a whole batch when a bound is crossed; the last entry
+     * stays if it is within the bounds, even above the low marks
+     */
+    void shrink() {
+        if (map.size() <= max_size && total_weight <= max_weight)
+            return;
+        while (!map.empty() &&
+               (map.size() > low_size || total_weight > low_weight)) {
+            if (map.size() == 1 && map.size() <= max_size &&
+                total_weight <= max_weight)
+                break;
+            evict();
+        }
+    }
+    /**
+     * the entries of other appended in order, with their expiry;
+     * the cold ones are unpacked, then the zones are set up again
+     */
+    void copy_entries(const basic_lru& other) {
+        low_size = other.low_size;
+        low_weight = other.low_weight;
+        clock = other.clock;
+        write_ttl = other.write_ttl;
+        access_ttl = other.access_ttl;
+        hot_fraction = other.hot_fraction;
+        map.reserve(other.map.size());
+        for (auto it = other.map.cbegin(); it != other.map.cend(); ++it) {
+            const entry& from = it->second;
+            entry e{from.value, from.weight, nullptr, from.write_deadline,
+                    nullptr};
+            if constexpr (value_codec<Value>::enabled) {
+                if (from.packed) {
+                    e.value = value_codec<Value>::unpack(*from.packed);
+                    e.weight = weigh(it->first, e.value);
+                }
+            }
+            if (from.expiry)
+                e.expiry = timers.schedule(it->first, from.expiry->deadline);
+            map.insert({it->first, e});
+            total_weight += e.weight;
+        }
+        hot_count = zoned() ? map.size() : 0;
+        boundary = zoned() ? map.begin() : map.end();
+        if (zoned())
+            cool();
+    }
+    size_t expire(unsigned long long now) {
+        return timers.advance(now, [this](timer* t) {
+            auto iter = map.find(t->key);
+            // the wheel deletes the timer itself
+            iter->second.expiry = nullptr;
+            erase(iter);
+        });
+    }
+    unsigned long long deadline(unsigned long long write_deadline,
+                                unsigned long long now) const {
+        if (!access_ttl || now + access_ttl > write_deadline)
+            return write_deadline;
+        return now + access_ttl;
+    }
+
+    /**
+     * read the clock and drop what has expired, if anything
+     * can expire; timed: the caller is about to schedule a timer
+     */
+    unsigned long long tick(bool timed) {
+        if (!timed && timers.empty())
+            return 0;
+        unsigned long long now = clock->now();
+        expire(now);
+        return now;
+    }
+    /**
+     * the body of save(), iter is map.find(v.first)
+     * Pair is value_type or anything with the same first and second
+     */
+    template <class Pair>
+    void store(const Pair& v,
+               unsigned long long ttl,
+               unsigned long long now,
+               iterator iter) {
+        bool timed = ttl || access_ttl;
+        unsigned long long write_deadline = ttl ? now + ttl : NEVER;
+        size_t w = weigh(v.first, v.second);
+        if (w > max_weight) {
+            // it could never stay: only this key goes, as if evicted
+            counters.add(stat_counters::evictions);
+            notify(access_observer<Key>::evict, v.first);
+            if (iter != map.end())
+                erase(iter);
+            if (tier)
+                tier->erase(v.first);
+            return;
+        }
+        if (iter == map.end()) {
+            counters.add(stat_counters::inserts);
+            timer* expiry = nullptr;
+            if (timed)
+                expiry = timers.schedule(v.first, deadline(write_deadline, now));
+            if (tier)
+                tier->erase(v.first);
+            entry e{v.second, w, expiry, write_deadline, nullptr};
+            iterator added = map.insert({v.first, e}).first;
+            if (zoned()) {
+                hot_count++;
+                if (boundary == map.end())
+                    boundary = added;
+            }
+        } else {
+            // update in place, only the order changes
+            counters.add(stat_counters::updates);
+            entry& e = iter->second;
+            total_weight -= e.weight;
+            if (timed && e.expiry) {
+                timers.reschedule(e.expiry, deadline(write_deadline, now));
+            } else if (timed) {
+                e.expiry = timers.schedule(v.first, deadline(write_deadline, now));
+            } else if (e.expiry) {
+                timers.cancel(e.expiry);
+                e.expiry = nullptr;
+            }
+            if (zoned())
+                heat(iter, false);
+            e.value = v.second;
+            e.weight = w;
+            e.write_deadline = write_deadline;
+            map.move_to_back(iter);
+        }
+        total_weight += w;
+        if (zoned())
+            cool();
+        shrink();
+    }
+    /**
+     * the body of get(), iter is map.find(key)
+     */
+    Value* touch(iterator iter, unsigned long long now) {
+        if (iter == map.end())
+            return nullptr;
+        entry& e = iter->second;
+        if (access_ttl && e.expiry)
+            timers.reschedule(e.expiry, deadline(e.write_deadline, now));
+        if (zoned()) {
+            heat(iter, true);
+            // unpacked, it may be too heavy for a lowered max_weight
+            if (e.weight > max_weight) {
+                evict(iter);
+                return nullptr;
+            }
+        }
+        map.move_to_back(iter);
+        if (zoned()) {
+            // and the cache heavier than its bound
+            cool();
+            shrink();
+        }
+        return &(e.value);
+    }
+    /**
+     * a miss of the cache, served by the victim tier if it has key
+     */
+    Value* promote(key_arg key) {
+        std::unique_ptr<Value> value = tier->take(key);
+        if (!value)
+            return nullptr;
+        unsigned long long now = tick(write_ttl || access_ttl);
+        store(value_type(key, *value), write_ttl, now, map.end());
+        // an entry heavier than max_weight was not kept
+        iterator iter = map.find(key);
+        return iter == map.end() ? nullptr : &(iter->second.value);
+    }
+    /**
+     * hash keys [begin, end) into index, then prefetch in stages
+     */
+    static constexpr size_t BATCH = 16;
+    template <class KeyOf>
+    void prefetch(size_t* index, size_t begin, size_t end, KeyOf key_of) {
+        for (size_t i = begin; i < end; i++) {
+            index[i - begin] = map.bucket_of(key_of(i));
+            map.prefetch_bucket(index[i - begin]);
+        }
+        for (size_t i = 0; i < end - begin; i++)
+            map.prefetch_node(index[i]);
+        for (size_t i = 0; i < end - begin; i++)
+            map.prefetch_value(index[i]);
+    }
 
    public:
-    lru(int size) : max_size(size) {
-        map.hashmap::size = size;
-        map.hashmap::capacity = 4 * size / 3 + 5;
-        map.hashmap<Integer, Matrix<int>, Hash, Equal>::total_clear();
-        map.history.clear();
-        map.hashmap::resize(map.buckets, map.hashmap::capacity);
+    basic_lru(int size, const Alloc& alloc = Alloc())
+        : basic_lru(size, size_t(-1), default_weight<Key, Value>, alloc) {}
+    /**
+     * bounded by both the number of entries and the total weight,
+     * the weight of an entry is weigh(key, value)
+     * the table and its entries are allocated by alloc; the timers
+     * and the loads in flight use the default heap
+     */
+    basic_lru(int size,
+              size_t max_weight,
+              const weigher& weigh = default_weight<Key, Value>,
+              const Alloc& alloc = Alloc())
+        : map(alloc),
+          max_size(size),
+          max_weight(max_weight),
+          low_size(size),
+          low_weight(max_weight),
+          total_weight(0),
+          weigh(weigh),
+          clock(steady_ttl_clock::instance()),
+          observer(nullptr),
+          tier(nullptr),
+          hot_fraction(1),
+          hot_count(0),
+          write_ttl(0),
+          access_ttl(0) {
+        map.reserve(size);
+    }
+    /**
+     * a copy has the same entries in the same order, the same bounds,
+     * weigher, clock, expiry and zones; its counters, histograms and
+     * loads in flight start afresh, and the observer and the victim
+     * tier of other are not shared
+     */
+    basic_lru(const basic_lru& other)
+        : basic_lru(int(other.max_size),
+                    other.max_weight,
+                    other.weigh,
+                    Alloc(other.map.alloc)) {
+        copy_entries(other);
+    }
+    basic_lru& operator=(const basic_lru& other) {
+        if (this == &other)
+            return *this;
+        clear();
+        max_size = other.max_size;
+        max_weight = other.max_weight;
+        weigh = other.weigh;
+        counters.reset();
+        copy_entries(other);
+        return *this;
+    }
+    ~basic_lru() { drop_packed(false); }
+
+    size_t size() const { return map.size(); }
+    size_t weight() const { return total_weight; }
+    size_t capacity() const { return max_size; }
+    /**
+     * the counters since construction or the last reset_stats(),
+     * e.g. for a metrics exporter; size and weight are current
+     */
+    cache_stats stats() const {
+        return cache_stats{counters.get(stat_counters::hits),
+                           counters.get(stat_counters::misses),
+                           counters.get(stat_counters::inserts),
+                           counters.get(stat_counters::updates),
+                           counters.get(stat_counters::evictions),
+                           counters.get(stat_counters::load_successes),
+                           counters.get(stat_counters::load_failures),
+                           map.size(),
+                           total_weight};
+    }
+    void reset_stats() { counters.reset(); }
+    /**
+     * how the table under the cache spreads its keys
+     */
+    table_diagnostics diagnostics() const { return map.diagnostics(); }
+#ifdef SJTU_ALLOC_STATS
+    /**
+     * the allocations of the table under the cache
+     */
+    const alloc_account& allocations() const { return map.allocations; }
+    void reset_allocations() { map.allocations.reset(); }
+#endif
+#ifdef SJTU_LATENCY
+    /**
+     * the time taken by save and get, and by the expands and
+     * removes of the table under the cache
+     */
+    const latency_histogram& save_latency() const { return save_histogram; }
+    const latency_histogram& get_latency() const { return get_histogram; }
+    const latency_histogram& expand_latency() const {
+        return map.expand_latency;
     }
-    ~lru() {}
+    const latency_histogram& remove_latency() const {
+        return map.remove_latency;
+    }
+    void reset_latency() {
+        save_histogram.reset();
+        get_histogram.reset();
+        map.expand_latency.reset();
+        map.remove_latency.reset();
+    }
+#endif
+    /**
+     * count a loader call made outside get_or_load (e.g. async_lru)
+     */
+    void count_load(bool success) {
+        counters.add(success ? stat_counters::load_successes
+                             : stat_counters::load_failures);
+    }
+
+    /**
+     * change the bounds at runtime (e.g. under memory pressure)
+     * size/max_weight are the high watermarks: crossing one evicts a
+     * batch down to low_size/low_weight, so the eviction work is paid
+     * once per batch instead of on every save. by default the low
+     * watermark equals the high one and each save evicts just enough.
+     * shrinking evicts at once and gives back the extra buckets.
+     */
+    void set_capacity(size_t size, size_t low = size_t(-1)) {
+        max_size = size;
+        low_size = low < size ? low : size;
+        if (zoned())
+            cool();
+        shrink();
+        if (map.capacity > 4 * (4 * size / 3 + 5))
+            map.rehash(4 * size / 3 + 5);
+        map.reserve(size);
+    }
+    /**
+     * keep plain values only for the most recent fraction f of the
+     * capacity and compress the older entries; a hit unpacks the
+     * entry and makes it the most recent. a cold entry weighs its
+     * compressed bytes, so under a weight bound more entries fit.
+     * 1 (the default) keeps every value plain. needs a
+     * value_codec<Value>, e.g. for an integer Matrix.
+     */
+    void set_hot_fraction(double f) {
+        static_assert(value_codec<Value>::enabled, "no codec for Value");
+        if (!zoned() && f < 1) {
+            hot_count = map.size();
+            boundary = map.begin();
+        } else if (zoned() && f >= 1) {
+            drop_packed(true);
+            hot_count = 0;
+            boundary = iterator();
+        }
+        hot_fraction = f;
+        if (zoned())
+            cool();
+        shrink();
+    }
+    /**
+     * how many entries are compressed
+     */
+    size_t cold_size() const { return zoned() ? map.size() - hot_count : 0; }
+    void set_max_weight(size_t max, size_t low = size_t(-1)) {
+        max_weight = max;
+        low_weight = low < max ? low : max;
+        shrink();
+    }
+
+    /**
+     * ttls are counted in ticks of the clock (milliseconds of the
+     * steady clock by default), 0 means no expiry of that kind
+     * the clock should be set before any entry is saved
+     */
+    void set_clock(ttl_clock* c) { clock = c; }
+    /**
+     * every save, get and eviction is reported to o, nullptr for none
+     * returns the observer it replaces
+     */
+    access_observer<Key>* set_observer(access_observer<Key>* o) {
+        access_observer<Key>* previous = observer;
+        observer = o;
+        return previous;
+    }
+    /**
+     * evicted entries go to t, and a get missing the cache is served
+     * from t (the entry moves back into the cache); nullptr for none
+     */
+    void set_victim_tier(victim_tier<Key, Value>* t) { tier = t; }
+    void set_expire_after_write(unsigned long long ttl) { write_ttl = ttl; }
+    void set_expire_after_access(unsigned long long ttl) { access_ttl = ttl; }
+    /**
+     * remove every expired entry now instead of waiting for
+     * the next save or get, return how many were removed
+     */
+    size_t cleanup() {
+        if (timers.empty())
+            return 0;
+        return expire(clock->now());
+    }
+
     /**
      * save the value_pair in the memory
      * delete something in the memory if necessary
+     * an entry heavier than max_weight is not kept (nor the old
+     * value of its key), the other entries are left alone
      */
-    void save(const value_type& v) {
-        map.insert(v);
-        while (map.size() > max_size)
-            map.remove(map.begin());
-        return;
+    void save(const value_type& v) { save(v, write_ttl); }
+    /**
+     * the same, but this entry expires ttl ticks after the write
+     */
+    void save(const value_type& v, unsigned long long ttl) {
+        SJTU_TIMED(save_histogram);
+        notify(access_observer<Key>::save, v.first);
+        unsigned long long now = tick(ttl || access_ttl);
+        store(v, ttl, now, map.find(v.first));
+    }
+    /**
+     * save(value_type(key, value)) without making the pair
+     */
+    void save(key_arg key, value_arg value) {
+        SJTU_TIMED(save_histogram);
+        notify(access_observer<Key>::save, key);
+        unsigned long long now = tick(write_ttl || access_ttl);
+        store(arg_pair{key, value}, write_ttl, now, map.find(key));
     }
     /**
      * return a pointer contain the value
      */
-    Matrix<int>* get(const Integer& v) {
-        auto iter = map.find(v);
-        if (iter == map.end())
-            return nullptr;
-        auto _iter = map.insert({v, iter.ptr->val_ptr->second}).first;
-        return &(_iter.ptr->val_ptr->second);
+    Value* get(key_arg v) {
+        SJTU_TIMED(get_histogram);
+        unsigned long long now = tick(false);
+        iterator iter = map.find(v);
+        bool cached = iter != map.end();
+        Value* result = touch(iter, now);
+        // an entry touch() evicted went to the tier, it stays there
+        if (!cached && tier)
+            result = promote(v);
+        counters.add(result ? stat_counters::hits : stat_counters::misses);
+        notify(result ? access_observer<Key>::hit : access_observer<Key>::miss,
+               v);
+        return result;
+    }
+
+    /**
+     * save n value_pairs, the same as n calls of save() in order
+     * the keys of a whole batch are hashed first and their buckets
+     * and nodes prefetched stage by stage, so the cache misses of
+     * the batch overlap instead of being taken one after another
+     */
+    template <class Pair>
+    void save_many(const Pair* values, size_t n) {
+        unsigned long long now = tick(write_ttl || access_ttl);
+        size_t index[BATCH];
+        for (size_t begin = 0; begin < n; begin += BATCH) {
+            size_t end = begin + BATCH < n ? begin + BATCH : n;
+            size_t capacity = map.capacity;
+            prefetch(index, begin, end, [values](size_t i) -> const Key& {
+                return values[i].first;
+            });
+            for (size_t i = begin; i < end; i++) {
+                // saving may have grown the table under the batch
+                auto iter = capacity == map.capacity
+                                ? map.find_hashed(index[i - begin],
+                                                  values[i].first)
+                                : map.find(values[i].first);
+                notify(access_observer<Key>::save, values[i].first);
+                store(values[i], write_ttl, now, iter);
+            }
+        }
+    }
+    /**
+     * the same as out[i] = get(keys[i]) for every i in order
+     * return how many keys were found
+     * (like get(), an entry taken back from the victim tier or
+     * unpacked may evict one an earlier pointer of the batch points to)
+     */
+    size_t get_many(const Key* keys, size_t n, Value** out) {
+        unsigned long long now = tick(false);
+        size_t index[BATCH];
+        size_t hits = 0;
+        for (size_t begin = 0; begin < n; begin += BATCH) {
+            size_t end = begin + BATCH < n ? begin + BATCH : n;
+            prefetch(index, begin, end,
+                     [keys](size_t i) -> const Key& { return keys[i]; });
+            size_t capacity = map.capacity;
+            for (size_t i = begin; i < end; i++) {
+                // promoting from the tier may have grown the table
+                iterator iter =
+                    capacity == map.capacity
+                        ? map.find_hashed(index[i - begin], keys[i])
+                        : map.find(keys[i]);
+                bool cached = iter != map.end();
+                out[i] = touch(iter, now);
+                if (!cached && tier)
+                    out[i] = promote(keys[i]);
+                counters.add(out[i] ? stat_counters::hits
+                                    : stat_counters::misses);
+                notify(out[i] ? access_observer<Key>::hit
+                              : access_observer<Key>::miss,
+                       keys[i]);
+                hits += out[i] != nullptr;
+            }
+        }
+        return hits;
+    }
+
+    /**
+     * return the value of key, saving loader(key) on a miss
+     * callers missing the same key at the same time share one call
+     * of the loader: the first runs it, the others wait for its
+     * result (or its exception). get_or_load can be called from many
+     * threads at once, the other members are not synchronized.
+     */
+    template <class Loader>
+    Value get_or_load(key_arg key, Loader&& loader) {
+        std::unique_lock<std::mutex> guard(flight_lock);
+        Value* hit = get(key);
+        if (hit)
+            return *hit;
+        auto in_flight = flights.find(key);
+        if (in_flight != flights.end()) {
+            flight* f = in_flight->second;
+            f->waiters++;
+            f->finished.wait(guard, [f] { return f->done; });
+            f->waiters--;
+            bool last = !f->waiters;
+            if (f->error) {
+                std::exception_ptr error = f->error;
+                if (last)
+                    delete f;
+                std::rethrow_exception(error);
+            }
+            Value result = *(f->result);
+            if (last)
+                delete f;
+            return result;
+        }
+        flight* f = new flight;
+        flights.insert({key, f});
+        guard.unlock();
+        try {
+            Value loaded = loader(key);
+            guard.lock();
+            save(value_type(key, loaded));
+            // counted once saved: a throwing save is a failed load
+            counters.add(stat_counters::load_successes);
+            if (f->waiters)
+                f->result = new Value(loaded);
+            finish(f, key);
+            return loaded;
+        } catch (...) {
+            if (!guard.owns_lock())
+                guard.lock();
+            counters.add(stat_counters::load_failures);
+            f->error = std::current_exception();
+            finish(f, key);
+            throw;
+        }
+    }
+
+   private:
+    // called with flight_lock held
+    void finish(flight* f, key_arg key) {
+        flights.remove(flights.find(key));
+        f->done = true;
+        if (f->waiters)
+            f->finished.notify_all();
+        else
+            delete f;
+    }
+
+    /**
+     * snapshot layout, integers in native byte order:
+     *   8 bytes magic, u32 version, u32 key tag, u64 count,
+     *   u32 value tag, u32 reserved (the tags of serializer<>),
+     *   count entries from the LRU end to the MRU end, each
+     *   u32 length + key bytes, u32 length + value bytes,
+     *   u64 FNV-1a of the entries
+     */
+    static constexpr char SNAPSHOT_MAGIC[8] = {'S', 'J', 'L', 'R',
+                                               'U', 'S', 'N', 'P'};
+    static constexpr unsigned SNAPSHOT_VERSION = 2;
+    static constexpr size_t SNAPSHOT_HEADER = 32;
+
+    /**
+     * walk the entries of a snapshot without decoding them,
+     * false if a length runs past the checksum
+     */
+    static bool snapshot_intact(const char* begin,
+                                const char* end,
+                                unsigned long long count) {
+        for (unsigned long long i = 0; i < 2 * count; i++) {
+            unsigned len;
+            if (size_t(end - begin) < sizeof(len))
+                return false;
+            std::memcpy(&len, begin, sizeof(len));
+            begin += sizeof(len);
+            if (size_t(end - begin) < len)
+                return false;
+            begin += len;
+        }
+        return begin == end;
+    }
+    static const char* snapshot_read(const char*& in, unsigned& len) {
+        std::memcpy(&len, in, sizeof(len));
+        const char* data = in + sizeof(len);
+        in = data + len;
+        return data;
+    }
+
+   public:
+    /**
+     * drop every entry
+     */
+    void clear() {
+        drop_packed(false);
+        timers.clear();
+        map.clear();
+        total_weight = 0;
+        hot_count = 0;
+        boundary = map.end();
+    }
+
+    /**
+     * write every entry to path, in the order of the history, so a
+     * later load_snapshot() restores the recency order as well
+     * expiry times are not written, restored entries get the default
+     * ttls of the cache they are loaded into. throws
+     * std::runtime_error if the file cannot be written.
+     */
+    void save_snapshot(const std::string& path) {
+        tick(false);
+        std::FILE* out = std::fopen(path.c_str(), "wb");
+        if (!out)
+            throw std::runtime_error("cannot write snapshot " + path);
+        char header[SNAPSHOT_HEADER] = {};
+        unsigned version = SNAPSHOT_VERSION;
+        unsigned key_tag = serializer<Key>::tag;
+        unsigned value_tag = serializer<Value>::tag;
+        unsigned long long count = map.size();
+        std::memcpy(header, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        std::memcpy(header + 8, &version, sizeof(version));
+        std::memcpy(header + 12, &key_tag, sizeof(key_tag));
+        std::memcpy(header + 16, &count, sizeof(count));
+        std::memcpy(header + 24, &value_tag, sizeof(value_tag));
+        std::fwrite(header, 1, sizeof(header), out);
+        // entries are encoded into one buffer and written in large
+        // blocks, the checksum is taken block by block
+        std::vector<char> buffer;
+        unsigned long long checksum = fnv1a(nullptr, 0);
+        auto flush = [&]() {
+            checksum = fnv1a(buffer.data(), buffer.size(), checksum);
+            std::fwrite(buffer.data(), 1, buffer.size(), out);
+            buffer.clear();
+        };
+        auto append = [&buffer](size_t len) {
+            unsigned prefix = len;
+            size_t at = buffer.size();
+            buffer.resize(at + sizeof(prefix) + len);
+            std::memcpy(buffer.data() + at, &prefix, sizeof(prefix));
+            return buffer.data() + at + sizeof(prefix);
+        };
+        for_each([&](const Key& key, const Value& value) {
+            serializer<Key>::write(key, append(serializer<Key>::size(key)));
+            serializer<Value>::write(value,
+                                     append(serializer<Value>::size(value)));
+            if (buffer.size() >= (1 << 16))
+                flush();
+        });
+        flush();
+        std::fwrite(&checksum, 1, sizeof(checksum), out);
+        bool failed = std::ferror(out);
+        if (std::fclose(out) || failed)
+            throw std::runtime_error("cannot write snapshot " + path);
+    }
+    /**
+     * replace the content with the snapshot at path, return the
+     * number of entries restored. the file is read at once and
+     * checked before anything changes, the table is sized once for
+     * the whole snapshot; when it holds more than the capacity, only
+     * the most recent entries are restored. throws std::runtime_error
+     * (leaving the cache as it was) if the file is missing, of
+     * another format or version, written for other Key or Value
+     * types, truncated or corrupted. the entries are decoded before
+     * the cache is cleared, so a record that does not decode changes
+     * nothing either.
+     */
+    size_t load_snapshot(const std::string& path) {
+        std::FILE* in = std::fopen(path.c_str(), "rb");
+        if (!in)
+            throw std::runtime_error("cannot read snapshot " + path);
+        std::vector<char> data;
+        long len = -1;
+        if (!std::fseek(in, 0, SEEK_END))
+            len = std::ftell(in);
+        if (len >= 0) {
+            data.resize(len);
+            std::rewind(in);
+            if (std::fread(data.data(), 1, len, in) != size_t(len))
+                len = -1;
+        }
+        std::fclose(in);
+        if (len < 0)
+            throw std::runtime_error("cannot read snapshot " + path);
+
+        const size_t tail = sizeof(unsigned long long);
+        unsigned version, key_tag, value_tag;
+        unsigned long long count, checksum;
+        if (data.size() < SNAPSHOT_HEADER + tail ||
+            std::memcmp(data.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)))
+            throw std::runtime_error("not a snapshot: " + path);
+        std::memcpy(&version, data.data() + 8, sizeof(version));
+        std::memcpy(&key_tag, data.data() + 12, sizeof(key_tag));
+        std::memcpy(&count, data.data() + 16, sizeof(count));
+        std::memcpy(&value_tag, data.data() + 24, sizeof(value_tag));
+        std::memcpy(&checksum, data.data() + data.size() - tail, tail);
+        if (version != SNAPSHOT_VERSION)
+            throw std::runtime_error("unknown snapshot version: " + path);
+        if (key_tag != serializer<Key>::tag ||
+            value_tag != serializer<Value>::tag)
+            throw std::runtime_error("snapshot of other types: " + path);
+        const char* begin = data.data() + SNAPSHOT_HEADER;
+        const char* end = data.data() + data.size() - tail;
+        if (fnv1a(begin, end - begin) != checksum ||
+            !snapshot_intact(begin, end, count))
+            throw std::runtime_error("corrupted snapshot: " + path);
+
+        unsigned long long skip = count > max_size ? count - max_size : 0;
+        std::vector<sjtu::pair<Key, Value>> decoded;
+        decoded.reserve(count - skip);
+        for (unsigned long long i = 0; i < count; i++) {
+            unsigned key_len, value_len;
+            const char* key = snapshot_read(begin, key_len);
+            const char* value = snapshot_read(begin, value_len);
+            if (i < skip)
+                continue;
+            decoded.emplace_back(serializer<Key>::read(key, key_len),
+                                 serializer<Value>::read(value, value_len));
+        }
+        clear();
+        map.reserve(decoded.size());
+        unsigned long long now = tick(write_ttl || access_ttl);
+        for (const auto& v : decoded)
+            store(v, write_ttl, now, map.find(v.first));
+        return map.size();
     }
+
     /**
      * just print everything in the memory
      * to debug or test.
@@ -757,10 +2233,194 @@ class lru {
      * change the order.
      */
     void print() {
-        sjtu ::linked_hashmap<Integer, Matrix<int>, Hash, Equal>::iterator it;
-        for (it = map.begin(); it != map.end(); it++) {
-            std ::cout << (*it).first.val << " " << (*it).second << std ::endl;
+        for_each([](const Key& key, const Value& value) {
+            print_key(std ::cout, key);
+            std ::cout << " " << value << '\n';
+        });
+        std ::cout.flush();
+    }
+    /**
+     * call f(key, value) for every entry, from the least to the
+     * most recently used, without changing the order
+     */
+    template <class F>
+    void for_each(F&& f) {
+        for (iterator it = map.begin(); it != map.end(); it++)
+            with_value(it,
+                       [&f, it](const Value& value) { f(it->first, value); });
+    }
+};
+
+using lru = basic_lru<Integer, Matrix<int>, Hash, Equal>;
+
+/**
+ * the containers on a std::pmr::memory_resource, e.g.
+ *   std::pmr::monotonic_buffer_resource arena;
+ *   sjtu::pmr::lru cache(1000, &arena);
+ */
+namespace pmr {
+template <class Key,
+          class T,
+          class Hash = std::hash<Key>,
+          class Equal = std::equal_to<Key>>
+using linked_hashmap =
+    sjtu::linked_hashmap<Key,
+                         T,
+                         Hash,
+                         Equal,
+                         std::pmr::polymorphic_allocator<pair<const Key, T>>>;
+template <class Key,
+          class Value,
+          class Hash = std::hash<Key>,
+          class Equal = std::equal_to<Key>>
+using basic_lru = sjtu::basic_lru<
+    Key,
+    Value,
+    Hash,
+    Equal,
+    std::pmr::polymorphic_allocator<pair<const Key, Value>>>;
+using lru = basic_lru<Integer, Matrix<int>, Hash, Equal>;
+}  // namespace pmr
+
+/**
+ * adaptive replacement cache (Megiddo & Modha)
+ * t1 keeps the keys seen only once recently, t2 the keys seen at
+ * least twice; b1 and b2 only remember the keys recently evicted from
+ * t1 and t2 (no values). a hit on a ghost list moves target (the
+ * wished size of t1) towards the list that would have kept the key,
+ * so the split between recency and frequency tunes itself.
+ * every list is a linked_hashmap, so its head is the LRU end.
+ */
+template <class Key,
+          class T,
+          class Hash = std::hash<Key>,
+          class Equal = std::equal_to<Key>>
+class arc {
+   public:
+    using value_type = pair<const Key, T>;
+
+   private:
+    using lmap = linked_hashmap<Key, T, Hash, Equal>;
+    using ghost = linked_hashmap<Key, bool, Hash, Equal>;
+    lmap t1, t2;
+    ghost b1, b2;
+    size_t max_size;
+    size_t target;
+    access_observer<Key>* observer;
+
+    void notify(typename access_observer<Key>::event e, const Key& key) {
+        if (observer)
+            observer->on_access(e, key);
+    }
+    /**
+     * evict one entry from t1 or t2 into its ghost list
+     * in_b2: the key being saved was found in b2
+     */
+    void replace(bool in_b2) {
+        if (t1.size() + t2.size() < max_size)
+            return;
+        if (!t1.empty() && (t1.size() > target || t2.empty() ||
+                            (in_b2 && t1.size() == target))) {
+            auto victim = t1.begin();
+            notify(access_observer<Key>::evict, victim->first);
+            b1.insert({victim->first, true});
+            t1.remove(victim);
+        } else if (!t2.empty()) {
+            auto victim = t2.begin();
+            notify(access_observer<Key>::evict, victim->first);
+            b2.insert({victim->first, true});
+            t2.remove(victim);
+        }
+    }
+
+   public:
+    arc(int size) : max_size(size), target(0), observer(nullptr) {}
+    ~arc() {}
+
+    size_t size() const { return t1.size() + t2.size(); }
+    /**
+     * the current wished size of the recency list
+     */
+    size_t recency_target() const { return target; }
+    access_observer<Key>* set_observer(access_observer<Key>* o) {
+        access_observer<Key>* previous = observer;
+        observer = o;
+        return previous;
+    }
+    /**
+     * save the value_pair in the memory
+     * delete something in the memory if necessary
+     */
+    void save(const value_type& v) {
+        notify(access_observer<Key>::save, v.first);
+        // a cache of capacity 0 keeps nothing
+        if (!max_size)
+            return;
+        auto iter = t1.find(v.first);
+        if (iter != t1.end()) {
+            t1.remove(iter);
+            t2.insert(v);
+            return;
+        }
+        if (t2.count(v.first)) {
+            t2.insert(v);
+            return;
+        }
+        auto ghost_iter = b1.find(v.first);
+        if (ghost_iter != b1.end()) {
+            size_t delta = b2.size() > b1.size() ? b2.size() / b1.size() : 1;
+            target = target + delta < max_size ? target + delta : max_size;
+            replace(false);
+            b1.remove(ghost_iter);
+            t2.insert(v);
+            return;
+        }
+        ghost_iter = b2.find(v.first);
+        if (ghost_iter != b2.end()) {
+            size_t delta = b1.size() > b2.size() ? b1.size() / b2.size() : 1;
+            target = target > delta ? target - delta : 0;
+            replace(true);
+            b2.remove(ghost_iter);
+            t2.insert(v);
+            return;
+        }
+        // a key nobody remembers
+        size_t total = t1.size() + t2.size() + b1.size() + b2.size();
+        if (t1.size() + b1.size() >= max_size) {
+            if (t1.size() < max_size) {
+                b1.remove(b1.begin());
+                replace(false);
+            } else {
+                notify(access_observer<Key>::evict, t1.begin()->first);
+                t1.remove(t1.begin());
+            }
+        } else if (total >= max_size) {
+            if (total >= 2 * max_size)
+                b2.remove(b2.begin());
+            replace(false);
+        }
+        t1.insert(v);
+    }
+    /**
+     * return a pointer contain the value
+     * a hit always ends at the MRU end of t2
+     */
+    T* get(const Key& key) {
+        auto iter = t2.find(key);
+        if (iter != t2.end()) {
+            notify(access_observer<Key>::hit, key);
+            t2.move_to_back(iter);
+            return &(iter->second);
+        }
+        iter = t1.find(key);
+        if (iter == t1.end()) {
+            notify(access_observer<Key>::miss, key);
+            return nullptr;
         }
+        notify(access_observer<Key>::hit, key);
+        value_type promoted(key, iter->second);
+        t1.remove(iter);
+        return &(t2.insert(promoted).first->second);
     }
 };
 }  // namespace sjtu
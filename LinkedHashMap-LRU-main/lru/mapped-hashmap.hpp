@@ -0,0 +1,430 @@
+#ifndef SJTU_MAPPED_HASHMAP_HPP
+#define SJTU_MAPPED_HASHMAP_HPP
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "utility.hpp"
+
+namespace sjtu {
+/**
+ * 64-bit FNV-1a of the bytes of a key, the default hash of a
+ * mapped_hashmap: the buckets are on disk, so the hash has to be the
+ * same in every build, which std::hash does not promise. keys with
+ * padding or several representations of one value (floating point)
+ * need a hash of their own.
+ */
+template <class Key>
+struct mapped_hash {
+    static_assert(std::has_unique_object_representations<Key>::value,
+                  "equal keys must have equal bytes");
+    size_t operator()(const Key& key) const {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(&key);
+        unsigned long long h = 14695981039346656037ull;
+        for (size_t i = 0; i < sizeof(Key); i++) {
+            h ^= p[i];
+            h *= 1099511628211ull;
+        }
+        return size_t(h);
+    }
+};
+
+/**
+ * a linked_hashmap living in a memory-mapped file (POSIX only)
+ * every node is stored once and linked by offsets from the start of
+ * the file instead of pointers, so the file can be mapped again at
+ * any address: reopening a cache is one mmap, nothing is decoded.
+ * each node is on the chain of its bucket and on the history list,
+ * whose head is the least recently inserted or moved element.
+ * Key and T must be trivially copyable, the file is only readable by
+ * a build with the same layout of the nodes (checked on open).
+ * opening also follows every offset of the file once, so a damaged
+ * file is rejected instead of being read out of bounds.
+ * the file grows by doubling; iterators hold offsets and survive the
+ * growth, pointers and references into the map do not.
+ */
+template <class Key,
+          class T,
+          class Hash = mapped_hash<Key>,
+          class Equal = std::equal_to<Key>>
+class mapped_hashmap {
+    static_assert(std::is_trivially_copyable<Key>::value &&
+                      std::is_trivially_copyable<T>::value,
+                  "mapped nodes are written as raw bytes");
+
+   public:
+    typedef pair<const Key, T> value_type;
+
+   private:
+    // 0 is the header, so it doubles as the null offset
+    using offset = unsigned long long;
+    static constexpr char MAGIC[8] = {'S', 'J', 'M', 'A', 'P', 'H', 'M', '1'};
+    static constexpr unsigned VERSION = 2;
+    static constexpr offset INITIAL_BUCKETS = 16;
+
+    struct header {
+        char magic[8];
+        unsigned version;
+        unsigned node_size;
+        unsigned key_size;
+        unsigned value_size;
+        offset capacity;  // number of buckets
+        offset buckets;   // where the bucket array is
+        offset size;
+        offset head;
+        offset tail;
+        offset free;    // removed nodes, chained through chain
+        offset top;     // the arena is used up to here
+        offset length;  // bytes of the file
+    };
+    struct node {
+        offset chain;  // next node of the bucket
+        offset prev;
+        offset next;
+        size_t hash;
+        value_type value;
+    };
+
+    int fd;
+    char* base;
+    offset mapped;
+    Hash hash;
+    Equal equal;
+
+    header* meta() const { return reinterpret_cast<header*>(base); }
+    node* node_at(offset o) const { return reinterpret_cast<node*>(base + o); }
+    offset* bucket(size_t h) const {
+        return reinterpret_cast<offset*>(base + meta()->buckets) +
+               h % meta()->capacity;
+    }
+    static offset align(offset n) {
+        const offset a = alignof(node) > 8 ? alignof(node) : 8;
+        return (n + a - 1) / a * a;
+    }
+
+    void map_file(offset length) {
+        void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       fd, 0);
+        if (p == MAP_FAILED)
+            throw std::runtime_error("mapped_hashmap: mmap failed");
+        base = static_cast<char*>(p);
+        mapped = length;
+    }
+    /**
+     * make the file at least length bytes, moves base
+     */
+    void grow(offset length) {
+        offset old = meta()->length;
+        offset target = old * 2 > length ? old * 2 : length;
+        if (ftruncate(fd, target))
+            throw std::runtime_error("mapped_hashmap: cannot grow the file");
+        munmap(base, mapped);
+        base = nullptr;
+        map_file(target);
+        meta()->length = target;
+    }
+    /**
+     * bytes from the arena, moves base if the file has to grow
+     */
+    offset allocate(offset bytes) {
+        offset o = align(meta()->top);
+        if (o + bytes > meta()->length)
+            grow(o + bytes);
+        meta()->top = o + bytes;
+        return o;
+    }
+    offset new_node() {
+        offset o = meta()->free;
+        if (o) {
+            meta()->free = node_at(o)->chain;
+            return o;
+        }
+        return allocate(sizeof(node));
+    }
+    /**
+     * a new bucket array, every node linked again in history order
+     * the old array, half the size of the new one, stays unused
+     */
+    void rehash(offset capacity) {
+        offset array = allocate(capacity * sizeof(offset));
+        std::memset(base + array, 0, capacity * sizeof(offset));
+        meta()->buckets = array;
+        meta()->capacity = capacity;
+        for (offset o = meta()->head; o; o = node_at(o)->next) {
+            offset* b = bucket(node_at(o)->hash);
+            node_at(o)->chain = *b;
+            *b = o;
+        }
+    }
+    void create() {
+        offset length =
+            align(sizeof(header)) + INITIAL_BUCKETS * sizeof(offset);
+        if (ftruncate(fd, length))
+            throw std::runtime_error("mapped_hashmap: cannot create the file");
+        map_file(length);
+        header* h = meta();
+        std::memcpy(h->magic, MAGIC, sizeof(MAGIC));
+        h->version = VERSION;
+        h->node_size = sizeof(node);
+        h->key_size = sizeof(Key);
+        h->value_size = sizeof(T);
+        h->size = h->head = h->tail = h->free = 0;
+        h->length = length;
+        h->top = align(sizeof(header));
+        rehash(INITIAL_BUCKETS);
+    }
+    /**
+     * bytes from o are inside the used part of the arena
+     */
+    bool in_arena(offset o, offset bytes) const {
+        return o >= align(sizeof(header)) && align(o) == o &&
+               o <= meta()->top && bytes <= meta()->top - o;
+    }
+    void check(offset length) {
+        const header* h = meta();
+        if (std::memcmp(h->magic, MAGIC, sizeof(MAGIC)) ||
+            h->version != VERSION)
+            throw std::runtime_error("mapped_hashmap: not a map file");
+        if (h->node_size != sizeof(node) || h->key_size != sizeof(Key) ||
+            h->value_size != sizeof(T))
+            throw std::runtime_error("mapped_hashmap: another layout");
+        if (h->length != length || h->top > length)
+            throw std::runtime_error("mapped_hashmap: truncated file");
+        const std::runtime_error corrupted("mapped_hashmap: corrupted file");
+        if (!h->capacity || h->capacity > length / sizeof(offset) ||
+            !in_arena(h->buckets, h->capacity * sizeof(offset)))
+            throw corrupted;
+        // every chain and list stays in the arena and ends
+        offset count = 0;
+        for (offset b = 0; b < h->capacity; b++) {
+            offset o = reinterpret_cast<offset*>(base + h->buckets)[b];
+            for (; o; o = node_at(o)->chain)
+                if (!in_arena(o, sizeof(node)) || ++count > h->size ||
+                    node_at(o)->hash % h->capacity != b)
+                    throw corrupted;
+        }
+        if (count != h->size)
+            throw corrupted;
+        offset prev = 0;
+        count = 0;
+        for (offset o = h->head; o; prev = o, o = node_at(o)->next)
+            if (!in_arena(o, sizeof(node)) || ++count > h->size ||
+                node_at(o)->prev != prev)
+                throw corrupted;
+        if (count != h->size || h->tail != prev)
+            throw corrupted;
+        count = 0;
+        for (offset o = h->free; o; o = node_at(o)->chain)
+            if (!in_arena(o, sizeof(node)) ||
+                ++count > h->top / sizeof(node))
+                throw corrupted;
+    }
+    void close() {
+        if (base)
+            munmap(base, mapped);
+        if (fd >= 0)
+            ::close(fd);
+        base = nullptr;
+        fd = -1;
+    }
+
+   public:
+    /**
+     * open the map stored at path, creating an empty one if the file
+     * does not exist or is empty; throws std::runtime_error if it
+     * cannot be mapped or holds something else
+     */
+    explicit mapped_hashmap(const std::string& path)
+        : fd(-1), base(nullptr), mapped(0) {
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0)
+            throw std::runtime_error("mapped_hashmap: cannot open " + path);
+        try {
+            struct stat st;
+            if (fstat(fd, &st))
+                throw std::runtime_error("mapped_hashmap: cannot open " + path);
+            if (st.st_size == 0) {
+                create();
+            } else {
+                if (offset(st.st_size) < sizeof(header))
+                    throw std::runtime_error("mapped_hashmap: not a map file");
+                map_file(st.st_size);
+                check(st.st_size);
+            }
+        } catch (...) {
+            close();
+            throw;
+        }
+    }
+    mapped_hashmap(const mapped_hashmap&) = delete;
+    mapped_hashmap& operator=(const mapped_hashmap&) = delete;
+    /**
+     * the pages are written back by the system, see flush()
+     */
+    ~mapped_hashmap() { close(); }
+
+    class iterator {
+        friend class mapped_hashmap;
+        const mapped_hashmap* map;
+        offset pos;
+
+       public:
+        iterator(const mapped_hashmap* map = nullptr, offset pos = 0)
+            : map(map), pos(pos) {}
+        iterator& operator++() {
+            if (!pos)
+                throw std::runtime_error("invalid iterator");
+            pos = map->node_at(pos)->next;
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator to_return(*this);
+            ++*this;
+            return to_return;
+        }
+        /**
+         * --end() is the last element
+         */
+        iterator& operator--() {
+            offset prev =
+                pos ? map->node_at(pos)->prev : map->meta()->tail;
+            if (!prev)
+                throw std::runtime_error("invalid iterator");
+            pos = prev;
+            return *this;
+        }
+        iterator operator--(int) {
+            iterator to_return(*this);
+            --*this;
+            return to_return;
+        }
+        value_type& operator*() const {
+            if (!pos)
+                throw std::runtime_error("invalid iterator");
+            return map->node_at(pos)->value;
+        }
+        value_type* operator->() const noexcept {
+            return &(map->node_at(pos)->value);
+        }
+        bool operator==(const iterator& rhs) const { return pos == rhs.pos; }
+        bool operator!=(const iterator& rhs) const { return pos != rhs.pos; }
+    };
+
+    iterator begin() const { return iterator(this, meta()->head); }
+    iterator end() const { return iterator(this, 0); }
+    size_t size() const { return meta()->size; }
+    bool empty() const { return !meta()->size; }
+    size_t capacity() const { return meta()->capacity; }
+
+    iterator find(const Key& key) const {
+        size_t h = hash(key);
+        for (offset o = *bucket(h); o; o = node_at(o)->chain)
+            if (node_at(o)->hash == h &&
+                equal(node_at(o)->value.first, key))
+                return iterator(this, o);
+        return end();
+    }
+    size_t count(const Key& key) const { return find(key) != end(); }
+    T& at(const Key& key) const {
+        iterator iter = find(key);
+        if (iter == end())
+            throw std::runtime_error("mapped_hashmap: no such key");
+        return iter->second;
+    }
+
+    /**
+     * the same as linked_hashmap::insert: an existing key gets the
+     * new value and becomes the last element, and false is returned
+     */
+    pair<iterator, bool> insert(const value_type& value) {
+        iterator iter = find(value.first);
+        if (iter != end()) {
+            iter->second = value.second;
+            move_to_back(iter);
+            return {iter, false};
+        }
+        if (meta()->size + 1 > meta()->capacity * 3 / 4)
+            rehash(meta()->capacity * 2);
+        size_t h = hash(value.first);
+        offset o = new_node();
+        node* n = node_at(o);
+        new (&n->value) value_type(value);
+        n->hash = h;
+        offset* b = bucket(h);
+        n->chain = *b;
+        *b = o;
+        n->prev = meta()->tail;
+        n->next = 0;
+        if (meta()->tail)
+            node_at(meta()->tail)->next = o;
+        else
+            meta()->head = o;
+        meta()->tail = o;
+        meta()->size++;
+        return {iterator(this, o), true};
+    }
+    void remove(iterator pos) {
+        if (!pos.pos)
+            throw std::runtime_error("invalid iterator");
+        offset o = pos.pos;
+        node* n = node_at(o);
+        offset* link = bucket(n->hash);
+        while (*link != o)
+            link = &node_at(*link)->chain;
+        *link = n->chain;
+        if (n->prev)
+            node_at(n->prev)->next = n->next;
+        else
+            meta()->head = n->next;
+        if (n->next)
+            node_at(n->next)->prev = n->prev;
+        else
+            meta()->tail = n->prev;
+        n->chain = meta()->free;
+        meta()->free = o;
+        meta()->size--;
+    }
+    /**
+     * make the element the last inserted one
+     */
+    void move_to_back(iterator pos) {
+        offset o = pos.pos;
+        node* n = node_at(o);
+        if (meta()->tail == o)
+            return;
+        if (n->prev)
+            node_at(n->prev)->next = n->next;
+        else
+            meta()->head = n->next;
+        node_at(n->next)->prev = n->prev;
+        n->prev = meta()->tail;
+        n->next = 0;
+        node_at(meta()->tail)->next = o;
+        meta()->tail = o;
+    }
+    /**
+     * remove everything, the file keeps its length
+     */
+    void clear() {
+        header* h = meta();
+        h->size = h->head = h->tail = h->free = 0;
+        h->top = align(sizeof(header));
+        rehash(INITIAL_BUCKETS);
+    }
+    /**
+     * write the dirty pages back to the file now
+     */
+    void flush() {
+        if (msync(base, meta()->length, MS_SYNC))
+            throw std::runtime_error("mapped_hashmap: msync failed");
+    }
+};
+}  // namespace sjtu
+
+#endif
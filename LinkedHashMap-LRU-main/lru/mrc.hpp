@@ -0,0 +1,239 @@
+#ifndef SJTU_MRC_HPP
+#define SJTU_MRC_HPP
+
+#include <algorithm>
+#include <vector>
+#include "lru.hpp"
+
+namespace sjtu {
+/**
+ * estimates the hit ratio an lru would have at every capacity from
+ * the stream of gets it observes (SHARDS, Waldspurger et al.)
+ * only keys whose hash falls under rate * 2^24 are tracked, so the
+ * sample is spatial: a sampled key is seen at every access. for a
+ * sampled access, the reuse distance is the number of other sampled
+ * keys used since the last access of the key, found in a Fenwick
+ * tree over access times; divided by rate, it estimates the distance
+ * in the full stream. an lru of capacity c hits exactly the accesses
+ * whose distance is less than c, so a histogram of the distances is
+ * the whole miss-ratio curve.
+ * the sample has a fixed size (fixed-size SHARDS): past max_samples
+ * keys, the keys with the highest hashes are dropped and the
+ * threshold, and with it the rate, is lowered to the highest hash
+ * left out, so memory stays bounded however many keys there are.
+ * attach it with cache.set_observer(&estimator), through an
+ * observer_fan to share the cache with a trace, or call access().
+ */
+template <class Key,
+          class Hash = std::hash<Key>,
+          class Equal = std::equal_to<Key>>
+class mrc_estimator : public access_observer<Key> {
+    using event = typename access_observer<Key>::event;
+    static constexpr unsigned long long MODULUS = 1 << 24;
+
+    struct sample {
+        unsigned long long stamp;
+        Key key;
+    };
+    static bool lower(const sample& a, const sample& b) {
+        return a.stamp < b.stamp;
+    }
+
+    // the sampled keys, least recently used first, with the time
+    // of their last access
+    linked_hashmap<Key, size_t, Hash, Equal> last;
+    // the same keys in a heap, the highest hash on top
+    std::vector<sample> samples;
+    size_t max_samples;
+    double initial_rate;
+    // tree[t] counts the keys last accessed at time t
+    std::vector<int> tree;
+    size_t now;
+    unsigned long long threshold;
+    double rate;
+    size_t width;
+    // estimated accesses per distance bin of the given width,
+    // first accesses, and all accesses
+    std::vector<double> bins;
+    double cold;
+    double total;
+    Hash hash;
+
+    static unsigned long long mix(unsigned long long h) {
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9ull;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebull;
+        return h ^ (h >> 31);
+    }
+    void add(size_t t, int delta) {
+        for (; t < tree.size(); t += t & -t)
+            tree[t] += delta;
+    }
+    size_t prefix(size_t t) const {
+        size_t sum = 0;
+        for (; t; t -= t & -t)
+            sum += tree[t];
+        return sum;
+    }
+    /**
+     * the times ran out: number the sampled keys again from 1, in
+     * the order of their last access, with room for as many again
+     */
+    void renumber() {
+        size_t room = 4 * last.size() + 64;
+        if (room < tree.size())
+            room = tree.size();
+        tree.assign(room, 0);
+        now = 0;
+        for (auto it = last.begin(); it != last.end(); it++) {
+            it->second = ++now;
+            add(now, 1);
+        }
+    }
+    /**
+     * too many keys: lower the threshold to the highest hash and
+     * forget every key at or above it
+     */
+    void drop_highest() {
+        threshold = samples.front().stamp;
+        rate = double(threshold) / MODULUS;
+        while (!samples.empty() && samples.front().stamp >= threshold) {
+            auto iter = last.find(samples.front().key);
+            add(iter->second, -1);
+            last.remove(iter);
+            std::pop_heap(samples.begin(), samples.end(), lower);
+            samples.pop_back();
+        }
+    }
+
+   public:
+    /**
+     * rate: the fraction of keys sampled at first, in (0, 1]
+     * width: the capacities are told apart in steps of width entries
+     * max_samples: the most keys tracked at once, 0 for no bound
+     */
+    explicit mrc_estimator(double rate = 0.01,
+                           size_t width = 1,
+                           size_t max_samples = 8192)
+        : max_samples(max_samples),
+          initial_rate(rate),
+          tree(1024, 0),
+          now(0),
+          threshold((unsigned long long)(rate * MODULUS)),
+          rate(rate),
+          width(width ? width : 1),
+          cold(0),
+          total(0) {
+        if (!threshold)
+            threshold = 1;
+    }
+
+    void on_access(event e, const Key& key) override {
+        if (e == access_observer<Key>::hit || e == access_observer<Key>::miss)
+            access(key);
+    }
+    /**
+     * one get of key
+     */
+    void access(const Key& key) {
+        unsigned long long stamp = mix(hash(key)) % MODULUS;
+        if (stamp >= threshold)
+            return;
+        if (now + 1 >= tree.size())
+            renumber();
+        double weight = 1 / rate;
+        total += weight;
+        auto iter = last.find(key);
+        if (iter == last.end()) {
+            cold += weight;
+            last.insert({key, ++now});
+            add(now, 1);
+            if (max_samples) {
+                samples.push_back({stamp, key});
+                std::push_heap(samples.begin(), samples.end(), lower);
+                if (last.size() > max_samples)
+                    drop_highest();
+            }
+            return;
+        }
+        size_t distance = prefix(now) - prefix(iter->second);
+        size_t bin = size_t(distance / rate) / width;
+        if (bin >= bins.size())
+            bins.resize(bin + 1, 0);
+        bins[bin] += weight;
+        add(iter->second, -1);
+        iter->second = ++now;
+        last.move_to_back(iter);
+        add(now, 1);
+    }
+
+    /**
+     * the estimated hit ratio of an lru holding capacity entries
+     */
+    double hit_ratio_at(size_t capacity) const {
+        if (total == 0)
+            return 0;
+        double hits = 0;
+        for (size_t b = 0; b < bins.size() && b * width < capacity; b++) {
+            size_t covered = capacity - b * width;
+            hits += covered >= width ? bins[b] : bins[b] * covered / width;
+        }
+        return hits / total;
+    }
+    /**
+     * the smallest capacity reaching target, max_capacity if none
+     * up to it does
+     */
+    size_t suggest_capacity(double target, size_t max_capacity) const {
+        if (total == 0)
+            return max_capacity;
+        double hits = 0;
+        for (size_t b = 0; b < bins.size() && b * width < max_capacity; b++) {
+            if ((hits + bins[b]) / total >= target) {
+                // the part of the bin still needed, as in hit_ratio_at
+                double needed = (target * total - hits) / bins[b] * width;
+                size_t capacity = b * width + size_t(needed);
+                if (capacity < b * width + needed)
+                    capacity++;
+                return capacity < max_capacity ? capacity : max_capacity;
+            }
+            hits += bins[b];
+        }
+        return max_capacity;
+    }
+    /**
+     * set the capacity of cache to suggest_capacity(target, max_entries)
+     * and return it; the curve is over entries, not weight, so both
+     * bounds count entries and the max_weight of cache is kept
+     */
+    template <class Cache>
+    size_t autosize(Cache& cache, double target, size_t max_entries) const {
+        size_t capacity = suggest_capacity(target, max_entries);
+        cache.set_capacity(capacity);
+        return capacity;
+    }
+
+    /**
+     * the estimated number of gets seen, how many keys are tracked,
+     * and the fraction of keys sampled now
+     */
+    double accesses() const { return total; }
+    size_t sampled() const { return last.size(); }
+    double sample_rate() const { return rate; }
+    void clear() {
+        last.clear();
+        samples.clear();
+        rate = initial_rate;
+        threshold = (unsigned long long)(rate * MODULUS);
+        if (!threshold)
+            threshold = 1;
+        tree.assign(1024, 0);
+        now = 0;
+        bins.clear();
+        cold = total = 0;
+    }
+};
+}  // namespace sjtu
+
+#endif
@@ -0,0 +1,588 @@
+#ifndef SJTU_ORDERED_DICT_HPP
+#define SJTU_ORDERED_DICT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include "lru.hpp"
+
+namespace sjtu {
+/**
+ * a linked_hashmap laid out as a python dict: the entries are
+ * appended to a dense array in insertion order, and an open-addressed
+ * table of entry numbers finds them by hash. an entry number takes 1,
+ * 2 or 4 bytes, the least that can name every entry of the array, so
+ * a table of 256 slots costs 256 bytes. nothing links the entries:
+ * iterating is a scan of the array, and the only per-entry overhead
+ * is the hash.
+ * a removed entry leaves a hole (its table slot becomes DUMMY); the
+ * holes are squeezed out when the array is full, or by compact().
+ * moving an entry to the back (an update, move_to_back) is a removal
+ * and an append. removing never moves the other entries, but an
+ * insertion that makes the array grow or compact invalidates every
+ * iterator, as for a vector.
+ */
+template <class Key,
+          class T,
+          class Hash = std::hash<Key>,
+          class Equal = std::equal_to<Key>,
+          class Alloc = std::allocator<pair<const Key, T>>>
+class ordered_dict {
+   public:
+    using value_type = pair<const Key, T>;
+    using allocator_type = rebind_alloc<Alloc, value_type>;
+
+   private:
+    struct entry {
+        unsigned hash;
+        bool live;
+        alignas(value_type) unsigned char storage[sizeof(value_type)];
+
+        value_type& value() {
+            return *std::launder(reinterpret_cast<value_type*>(storage));
+        }
+    };
+    using entry_alloc = rebind_alloc<Alloc, entry>;
+    using byte_alloc = rebind_alloc<Alloc, unsigned char>;
+    // a slot holds EMPTY, DUMMY, or FIRST + the entry number
+    static constexpr size_t EMPTY = 0;
+    static constexpr size_t DUMMY = 1;
+    static constexpr size_t FIRST = 2;
+
+    entry* entries;
+    // entries appended, holes included; end() is used
+    size_t used;
+    // a table of table_size slots holds 2/3 as many entries
+    size_t entry_capacity;
+    size_t elements;
+    unsigned char* table;
+    size_t table_size;
+    // bytes per slot: 1, 2 or 4
+    size_t width;
+    Hash hash;
+    Equal eq;
+    allocator_type alloc;
+
+   public:
+#ifdef SJTU_ALLOC_STATS
+    // the index table counts as buckets, the entry array as values
+    alloc_account allocations;
+#endif
+
+   private:
+    /**
+     * EMPTY is 0, so an all-zero table is empty
+     */
+    size_t slot(size_t i) const {
+        switch (width) {
+            case 1:
+                return table[i];
+            case 2:
+                return reinterpret_cast<const std::uint16_t*>(table)[i];
+            default:
+                return reinterpret_cast<const std::uint32_t*>(table)[i];
+        }
+    }
+    void set_slot(size_t i, size_t v) {
+        switch (width) {
+            case 1:
+                table[i] = static_cast<unsigned char>(v);
+                break;
+            case 2:
+                reinterpret_cast<std::uint16_t*>(table)[i] =
+                    static_cast<std::uint16_t>(v);
+                break;
+            default:
+                reinterpret_cast<std::uint32_t*>(table)[i] =
+                    static_cast<std::uint32_t>(v);
+        }
+    }
+    /**
+     * the probe sequence of python: the low bits of the hash first,
+     * then the high bits shifted in until every slot is reachable
+     */
+    struct probe {
+        size_t at;
+        size_t perturb;
+        size_t mask;
+
+        probe(unsigned h, size_t size)
+            : at(h & (size - 1)), perturb(h), mask(size - 1) {}
+        void next() {
+            perturb >>= 5;
+            at = (at * 5 + perturb + 1) & mask;
+        }
+    };
+    /**
+     * the slot of key, or NIL_SLOT if it is not in the table
+     */
+    static constexpr size_t NIL_SLOT = ~size_t(0);
+    size_t find_slot(const Key& key, unsigned h) const {
+        for (probe p(h, table_size);; p.next()) {
+            size_t s = slot(p.at);
+            if (s == EMPTY)
+                return NIL_SLOT;
+            if (s == DUMMY)
+                continue;
+            entry& e = entries[s - FIRST];
+            if (e.hash == h && eq(e.value().first, key))
+                return p.at;
+        }
+    }
+    /**
+     * the slot holding entry number id
+     */
+    size_t slot_of(size_t id) const {
+        probe p(entries[id].hash, table_size);
+        while (slot(p.at) != FIRST + id)
+            p.next();
+        return p.at;
+    }
+    void put(size_t id) {
+        probe p(entries[id].hash, table_size);
+        while (slot(p.at) != EMPTY)
+            p.next();
+        set_slot(p.at, FIRST + id);
+    }
+
+    entry* make_entries(size_t n) {
+        entry_alloc a(alloc);
+        entry* made = std::allocator_traits<entry_alloc>::allocate(a, n);
+#ifdef SJTU_ALLOC_STATS
+        allocations.allocated(alloc_account::values, n * sizeof(entry));
+#endif
+        return made;
+    }
+    void destroy_entries() {
+#ifdef SJTU_ALLOC_STATS
+        allocations.freed(alloc_account::values,
+                          entry_capacity * sizeof(entry));
+#endif
+        entry_alloc a(alloc);
+        std::allocator_traits<entry_alloc>::deallocate(a, entries,
+                                                       entry_capacity);
+    }
+    /**
+     * a zeroed table of size slots, wide enough for its entries
+     */
+    void make_table(size_t size) {
+        size_t capacity = size / 3 * 2;
+        width = capacity + FIRST <= 0xff ? 1
+                : capacity + FIRST <= 0xffff ? 2
+                                             : 4;
+        byte_alloc a(alloc);
+        table = std::allocator_traits<byte_alloc>::allocate(a, size * width);
+#ifdef SJTU_ALLOC_STATS
+        allocations.allocated(alloc_account::buckets, size * width);
+#endif
+        table_size = size;
+        for (size_t i = 0; i < size * width; i++)
+            table[i] = 0;
+    }
+    void destroy_table() {
+#ifdef SJTU_ALLOC_STATS
+        allocations.freed(alloc_account::buckets, table_size * width);
+#endif
+        byte_alloc a(alloc);
+        std::allocator_traits<byte_alloc>::deallocate(a, table,
+                                                      table_size * width);
+    }
+    /**
+     * the smallest power of two whose 2/3 holds n entries
+     */
+    static size_t table_for(size_t n) {
+        size_t size = 8;
+        while (size / 3 * 2 < n)
+            size *= 2;
+        return size;
+    }
+    /**
+     * move the live entries, in order and without holes, to a new
+     * array with room for n, and index them in a new table; return
+     * the new number of entry keep (or keep itself if none)
+     */
+    size_t rebuild(size_t n, size_t keep = NIL_SLOT) {
+        size_t size = table_for(n);
+        if (size / 3 * 2 > 0xfffffffeu - FIRST)
+            throw std::runtime_error("ordered_dict is full");
+        entry* moved = make_entries(size / 3 * 2);
+        size_t kept = keep;
+        size_t to = 0;
+        for (size_t from = 0; from < used; from++) {
+            entry& e = entries[from];
+            if (!e.live)
+                continue;
+            if (from == keep)
+                kept = to;
+            new (moved[to].storage) value_type(std::move(e.value()));
+            moved[to].hash = e.hash;
+            moved[to].live = true;
+            e.value().~value_type();
+            to++;
+        }
+        destroy_entries();
+        destroy_table();
+        entries = moved;
+        entry_capacity = size / 3 * 2;
+        used = to;
+        make_table(size);
+        for (size_t id = 0; id < used; id++)
+            put(id);
+        return kept;
+    }
+    /**
+     * room for one more entry at the back: squeeze the holes out, and
+     * double when they are fewer than the entries
+     */
+    size_t make_room(size_t keep = NIL_SLOT) {
+        if (used < entry_capacity)
+            return keep;
+        size_t holes = used - elements;
+        return rebuild(holes >= elements ? entry_capacity : elements * 2,
+                       keep);
+    }
+    /**
+     * drop entry id, its slot becomes DUMMY and it a hole (both stay
+     * taken until the next rebuild, so that there are never more
+     * taken slots than entries, and a search always meets EMPTY)
+     */
+    void drop(size_t id) {
+        set_slot(slot_of(id), DUMMY);
+        entries[id].value().~value_type();
+        entries[id].live = false;
+        elements--;
+    }
+    void init(size_t n) {
+        used = elements = 0;
+        size_t size = table_for(n);
+        entry_capacity = size / 3 * 2;
+        entries = make_entries(entry_capacity);
+        make_table(size);
+    }
+
+   public:
+    ordered_dict() { init(CAPACITY_DEFAULT); }
+    explicit ordered_dict(const Alloc& a) : alloc(a) {
+        init(CAPACITY_DEFAULT);
+    }
+    ordered_dict(const ordered_dict& other) : alloc(other.alloc) {
+        init(other.elements);
+        for (size_t id = 0; id < other.used; id++)
+            if (other.entries[id].live)
+                insert(other.entries[id].value());
+    }
+    ordered_dict& operator=(const ordered_dict& other) {
+        if (this == &other)
+            return *this;
+        clear();
+        reserve(other.elements);
+        for (size_t id = 0; id < other.used; id++)
+            if (other.entries[id].live)
+                insert(other.entries[id].value());
+        return *this;
+    }
+    ~ordered_dict() {
+        clear();
+        destroy_entries();
+        destroy_table();
+    }
+
+    class const_iterator;
+    class iterator {
+       public:
+        ordered_dict* map;
+        // the entry number, map->used is end()
+        size_t at;
+
+        iterator(ordered_dict* map = nullptr, size_t at = 0)
+            : map(map), at(at) {}
+
+        /**
+         * skips the holes
+         */
+        iterator& operator++() {
+            if (!map || at >= map->used)
+                throw std::runtime_error("invalid iterator");
+            do
+                at++;
+            while (at < map->used && !map->entries[at].live);
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator to_return(*this);
+            ++*this;
+            return to_return;
+        }
+        iterator& operator--() {
+            size_t prev = at;
+            do {
+                if (!map || !prev)
+                    throw std::runtime_error("invalid iterator");
+                prev--;
+            } while (!map->entries[prev].live);
+            at = prev;
+            return *this;
+        }
+        iterator operator--(int) {
+            iterator to_return(*this);
+            --*this;
+            return to_return;
+        }
+
+        value_type& operator*() const {
+            if (!map || at >= map->used)
+                throw std::runtime_error("invalid iterator");
+            return map->entries[at].value();
+        }
+        value_type* operator->() const noexcept {
+            return &map->entries[at].value();
+        }
+
+        bool operator==(const iterator& rhs) const { return at == rhs.at; }
+        bool operator!=(const iterator& rhs) const { return at != rhs.at; }
+        bool operator==(const const_iterator& rhs) const {
+            return at == rhs.at;
+        }
+        bool operator!=(const const_iterator& rhs) const {
+            return at != rhs.at;
+        }
+    };
+    class const_iterator {
+       public:
+        const ordered_dict* map;
+        size_t at;
+
+        const_iterator(const ordered_dict* map = nullptr, size_t at = 0)
+            : map(map), at(at) {}
+        const_iterator(const iterator& other)
+            : map(other.map), at(other.at) {}
+
+        const_iterator& operator++() {
+            if (!map || at >= map->used)
+                throw std::runtime_error("invalid iterator");
+            do
+                at++;
+            while (at < map->used && !map->entries[at].live);
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator to_return(*this);
+            ++*this;
+            return to_return;
+        }
+        const_iterator& operator--() {
+            size_t prev = at;
+            do {
+                if (!map || !prev)
+                    throw std::runtime_error("invalid iterator");
+                prev--;
+            } while (!map->entries[prev].live);
+            at = prev;
+            return *this;
+        }
+        const_iterator operator--(int) {
+            const_iterator to_return(*this);
+            --*this;
+            return to_return;
+        }
+
+        const value_type& operator*() const {
+            if (!map || at >= map->used)
+                throw std::runtime_error("invalid iterator");
+            return map->entries[at].value();
+        }
+        const value_type* operator->() const noexcept {
+            return &map->entries[at].value();
+        }
+
+        bool operator==(const iterator& rhs) const { return at == rhs.at; }
+        bool operator!=(const iterator& rhs) const { return at != rhs.at; }
+        bool operator==(const const_iterator& rhs) const {
+            return at == rhs.at;
+        }
+        bool operator!=(const const_iterator& rhs) const {
+            return at != rhs.at;
+        }
+    };
+
+   private:
+    size_t first_live() const {
+        size_t id = 0;
+        while (id < used && !entries[id].live)
+            id++;
+        return id;
+    }
+
+   public:
+    /**
+     * from the first inserted element to the last
+     */
+    iterator begin() { return iterator(this, first_live()); }
+    const_iterator cbegin() const {
+        return const_iterator(this, first_live());
+    }
+    iterator end() { return iterator(this, used); }
+    const_iterator cend() const { return const_iterator(this, used); }
+
+    size_t size() const { return elements; }
+    bool empty() const { return !elements; }
+    /**
+     * the entries the array holds, holes included, before it grows
+     */
+    size_t capacity() const { return entry_capacity; }
+    /**
+     * bytes per slot of the index table
+     */
+    size_t slot_width() const { return width; }
+
+    /**
+     * drop every element, the arrays are kept
+     */
+    void clear() {
+        for (size_t id = 0; id < used; id++)
+            if (entries[id].live)
+                entries[id].value().~value_type();
+        used = elements = 0;
+        for (size_t i = 0; i < table_size * width; i++)
+            table[i] = 0;
+    }
+    /**
+     * make room for n elements, so that inserting them never grows
+     */
+    void reserve(size_t n) {
+        if (n > entry_capacity)
+            rebuild(n);
+    }
+    /**
+     * squeeze the holes out of the array now, so a scan reads only
+     * live entries; invalidates the iterators
+     */
+    void compact() {
+        if (used != elements)
+            rebuild(entry_capacity);
+    }
+
+    /**
+     * as linked_hashmap::insert: a new key is appended and true
+     * returned; an existing key has its value updated, is moved to
+     * the back and false is returned
+     */
+    pair<iterator, bool> insert(const value_type& value) {
+        unsigned h = hash(value.first);
+        size_t s = find_slot(value.first, h);
+        if (s != NIL_SLOT) {
+            size_t id = slot(s) - FIRST;
+            entries[id].value().second = value.second;
+            move_to_back(iterator(this, id));
+            return {iterator(this, used - 1), false};
+        }
+        make_room();
+        entry& e = entries[used];
+        new (e.storage) value_type(value);
+        e.hash = h;
+        e.live = true;
+        put(used);
+        elements++;
+        return {iterator(this, used++), true};
+    }
+    /**
+     * erase the element pointed by the iterator, throw on end()
+     */
+    void remove(iterator pos) {
+        if (pos.at >= used || !entries[pos.at].live)
+            throw std::runtime_error("invalid iterator");
+        drop(pos.at);
+    }
+    /**
+     * make the element the last inserted one: it is moved to a new
+     * entry at the back and leaves a hole
+     */
+    void move_to_back(iterator pos) {
+        size_t id = pos.at;
+        if (id + 1 == used)
+            return;
+        id = make_room(id);
+        entry& from = entries[id];
+        entry& to = entries[used];
+        new (to.storage) value_type(std::move(from.value()));
+        to.hash = from.hash;
+        to.live = true;
+        set_slot(slot_of(id), FIRST + used);
+        from.value().~value_type();
+        from.live = false;
+        used++;
+    }
+
+    iterator find(const Key& key) {
+        size_t s = find_slot(key, hash(key));
+        return iterator(this, s == NIL_SLOT ? used : slot(s) - FIRST);
+    }
+    const_iterator find(const Key& key) const {
+        size_t s = find_slot(key, hash(key));
+        return const_iterator(this, s == NIL_SLOT ? used : slot(s) - FIRST);
+    }
+    /**
+     * 1 if key is in the map, 0 otherwise
+     */
+    size_t count(const Key& key) const {
+        return find_slot(key, hash(key)) != NIL_SLOT;
+    }
+
+    /**
+     * the value of key, throw if it is not in the map
+     */
+    T& at(const Key& key) {
+        size_t s = find_slot(key, hash(key));
+        if (s == NIL_SLOT)
+            throw std::runtime_error("T& at");
+        return entries[slot(s) - FIRST].value().second;
+    }
+    const T& at(const Key& key) const {
+        size_t s = find_slot(key, hash(key));
+        if (s == NIL_SLOT)
+            throw std::runtime_error("const T& at");
+        return entries[slot(s) - FIRST].value().second;
+    }
+    T& operator[](const Key& key) { return at(key); }
+    const T& operator[](const Key& key) const { return at(key); }
+
+    /**
+     * as hashmap::diagnostics(), for open addressing: chains[k] is the
+     * number of elements found at the k-th probe, max_chain and
+     * mean_chain the longest and the mean of those; probes_miss is
+     * the mean length of an unsuccessful search, starting from each
+     * slot of the table in turn
+     */
+    table_diagnostics diagnostics() const {
+        table_diagnostics d{elements, table_size, {}, 0, 0, 0, 0, 0, 0};
+        size_t walked = 0;
+        for (size_t id = 0; id < used; id++) {
+            if (!entries[id].live)
+                continue;
+            size_t len = 1;
+            for (probe p(entries[id].hash, table_size);
+                 slot(p.at) != FIRST + id; p.next())
+                len++;
+            if (len >= d.chains.size())
+                d.chains.resize(len + 1, 0);
+            d.chains[len]++;
+            walked += len;
+            if (len > d.max_chain)
+                d.max_chain = len;
+        }
+        d.mean_chain = d.probes_hit = elements ? double(walked) / elements : 0;
+        size_t missed = 0;
+        for (size_t start = 0; start < table_size; start++)
+            for (probe p(unsigned(start), table_size); slot(p.at) != EMPTY;
+                 p.next())
+                missed++;
+        d.probes_miss = double(missed) / table_size;
+        d.bucket_bytes = table_size * width;
+        d.node_bytes = elements * sizeof(entry);
+        return d;
+    }
+};
+}  // namespace sjtu
+
+#endif
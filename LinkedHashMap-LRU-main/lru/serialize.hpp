@@ -0,0 +1,201 @@
+#ifndef SJTU_SERIALIZE_HPP
+#define SJTU_SERIALIZE_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "class-integer.hpp"
+#include "class-matrix.hpp"
+
+namespace sjtu {
+/**
+ * how keys and values are turned into bytes for snapshots and logs
+ * size(v) is the number of bytes write(v, out) puts at out, and
+ * read(in, len) rebuilds the object from those len bytes, throwing
+ * std::runtime_error if len cannot be an encoding of it. tag names
+ * the encoding in file headers (its kind and the size of the type),
+ * so that a file is not read back as another type.
+ * specialize it for your own types.
+ */
+template <class T, class Enable = void>
+struct serializer;
+
+/**
+ * trivially copyable types are copied as they are
+ */
+template <class T>
+struct serializer<T,
+                  typename std::enable_if<
+                      std::is_trivially_copyable<T>::value>::type> {
+    static constexpr unsigned tag = 1u << 24 | sizeof(T);
+    static size_t size(const T&) { return sizeof(T); }
+    static void write(const T& v, char* out) {
+        std::memcpy(out, &v, sizeof(T));
+    }
+    static T read(const char* in, size_t len) {
+        if (len != sizeof(T))
+            throw std::runtime_error("bad record length");
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type raw;
+        std::memcpy(&raw, in, sizeof(T));
+        return *reinterpret_cast<T*>(&raw);
+    }
+};
+
+template <>
+struct serializer<Integer> {
+    static constexpr unsigned tag = 2u << 24 | sizeof(int);
+    static size_t size(const Integer&) { return sizeof(int); }
+    static void write(const Integer& v, char* out) {
+        std::memcpy(out, &v.val, sizeof(int));
+    }
+    static Integer read(const char* in, size_t len) {
+        if (len != sizeof(int))
+            throw std::runtime_error("bad record length");
+        int val;
+        std::memcpy(&val, in, sizeof(int));
+        return Integer(val);
+    }
+};
+
+template <>
+struct serializer<std::string> {
+    static constexpr unsigned tag = 3u << 24 | sizeof(char);
+    static size_t size(const std::string& v) { return v.size(); }
+    static void write(const std::string& v, char* out) {
+        std::memcpy(out, v.data(), v.size());
+    }
+    static std::string read(const char* in, size_t len) {
+        return std::string(in, len);
+    }
+};
+
+/**
+ * rows, columns, then the elements row by row
+ */
+template <class T>
+struct serializer<Matrix<T>> {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "matrix elements are copied as bytes");
+    static constexpr unsigned tag = 4u << 24 | sizeof(T);
+    static size_t size(const Matrix<T>& v) {
+        return 2 * sizeof(unsigned long long) +
+               v.RowSize() * v.ColSize() * sizeof(T);
+    }
+    static void write(const Matrix<T>& v, char* out) {
+        unsigned long long rows = v.RowSize(), cols = v.ColSize();
+        std::memcpy(out, &rows, sizeof(rows));
+        std::memcpy(out + sizeof(rows), &cols, sizeof(cols));
+        out += 2 * sizeof(unsigned long long);
+        for (size_t i = 0; i < rows && cols; i++) {
+            std::memcpy(out, &v[i][0], cols * sizeof(T));
+            out += cols * sizeof(T);
+        }
+    }
+    /**
+     * len must be exactly the header and rows * cols elements, and
+     * no dimension larger than len (an empty matrix)
+     */
+    static Matrix<T> read(const char* in, size_t len) {
+        const size_t head = 2 * sizeof(unsigned long long);
+        unsigned long long rows, cols;
+        if (len < head)
+            throw std::runtime_error("bad record length");
+        std::memcpy(&rows, in, sizeof(rows));
+        std::memcpy(&cols, in + sizeof(rows), sizeof(cols));
+        size_t elements = (len - head) / sizeof(T);
+        if ((len - head) % sizeof(T) || rows > len || cols > len ||
+            rows * cols != elements)
+            throw std::runtime_error("bad record length");
+        in += head;
+        Matrix<T> v(rows, cols);
+        for (size_t i = 0; i < rows && cols; i++) {
+            std::memcpy(&v[i][0], in, cols * sizeof(T));
+            in += cols * sizeof(T);
+        }
+        return v;
+    }
+};
+
+/**
+ * how values are compressed when they go cold in a basic_lru
+ * pack(v, out) replaces out with the compressed bytes of v,
+ * unpack(in) rebuilds the value. values without a codec stay plain.
+ */
+template <class T>
+struct value_codec {
+    static constexpr bool enabled = false;
+};
+
+/**
+ * integer matrices: rows, columns, then the elements row by row as
+ * the zigzag varint of their difference to the previous element
+ */
+template <class T>
+struct value_codec<Matrix<T>> {
+    static constexpr bool enabled = std::is_integral<T>::value;
+
+    static void put_varint(std::string& out, unsigned long long v) {
+        while (v >= 0x80) {
+            out.push_back(char(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back(char(v));
+    }
+    static unsigned long long get_varint(const char*& in) {
+        unsigned long long v = 0;
+        for (int shift = 0;; shift += 7) {
+            unsigned char c = *in++;
+            v |= (unsigned long long)(c & 0x7f) << shift;
+            if (!(c & 0x80))
+                return v;
+        }
+    }
+    static void pack(const Matrix<T>& v, std::string& out) {
+        out.clear();
+        put_varint(out, v.RowSize());
+        put_varint(out, v.ColSize());
+        // differences wrap around in unsigned arithmetic
+        unsigned long long prev = 0;
+        for (size_t i = 0; i < v.RowSize(); i++) {
+            for (size_t j = 0; j < v.ColSize(); j++) {
+                unsigned long long x = (long long)v[i][j];
+                unsigned long long d = x - prev;
+                prev = x;
+                put_varint(out, (d << 1) ^ (0 - (d >> 63)));
+            }
+        }
+    }
+    static Matrix<T> unpack(const std::string& in) {
+        const char* at = in.data();
+        size_t rows = get_varint(at);
+        size_t cols = get_varint(at);
+        Matrix<T> v(rows, cols);
+        unsigned long long prev = 0;
+        for (size_t i = 0; i < rows; i++) {
+            for (size_t j = 0; j < cols; j++) {
+                unsigned long long z = get_varint(at);
+                prev += (z >> 1) ^ (0 - (z & 1));
+                v[i][j] = T((long long)prev);
+            }
+        }
+        return v;
+    }
+};
+
+/**
+ * 64-bit FNV-1a, the checksum of snapshots and log records
+ */
+inline unsigned long long fnv1a(const char* data,
+                                size_t len,
+                                unsigned long long h = 14695981039346656037ull) {
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)data[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+}  // namespace sjtu
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef SJTU_SLAB_ALLOCATOR_HPP
+#define SJTU_SLAB_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <new>
+#include "lru.hpp"
+
+namespace sjtu {
+/**
+ * fixed-size blocks carved out of large chunks
+ * a request of up to MAX_BLOCK bytes is rounded up to a multiple of
+ * GRAIN and served from the free list of that size, or cut from the
+ * current chunk when the list is empty. a freed block is pushed on
+ * its free list (the link is stored in the block itself) and is
+ * never given back to malloc: the chunks are freed only with the
+ * pool. once a cache has reached its capacity, every eviction frees
+ * the blocks the next insertion takes, so the steady state makes no
+ * malloc call at all. larger or over-aligned requests (the bucket
+ * arrays) go to operator new.
+ * not synchronized, like the containers using it
+ */
+class slab_pool {
+   public:
+    static constexpr size_t GRAIN = alignof(std::max_align_t);
+    static constexpr size_t CLASSES = 16;
+    static constexpr size_t MAX_BLOCK = GRAIN * CLASSES;
+
+   private:
+    struct free_block {
+        free_block* next;
+    };
+    // a chunk starts with the link to the previous one
+    struct chunk {
+        chunk* previous;
+    };
+    static constexpr size_t HEADER =
+        (sizeof(chunk) + GRAIN - 1) / GRAIN * GRAIN;
+
+    free_block* free_lists[CLASSES];
+    chunk* chunks;
+    char* cursor;
+    char* limit;
+    size_t chunk_size;
+    size_t chunk_count;
+    size_t free_count;
+
+    void grow() {
+        void* raw = ::operator new(chunk_size);
+        chunk* c = static_cast<chunk*>(raw);
+        c->previous = chunks;
+        chunks = c;
+        chunk_count++;
+        // what was left of the last chunk is lost, at most a block
+        cursor = static_cast<char*>(raw) + HEADER;
+        limit = static_cast<char*>(raw) + chunk_size;
+    }
+
+   public:
+    /**
+     * chunk_size: the bytes asked from operator new at a time
+     */
+    explicit slab_pool(size_t chunk_size = 64 << 10)
+        : chunks(nullptr),
+          cursor(nullptr),
+          limit(nullptr),
+          chunk_size(chunk_size < HEADER + MAX_BLOCK ? HEADER + MAX_BLOCK
+                                                     : chunk_size),
+          chunk_count(0),
+          free_count(0) {
+        for (size_t i = 0; i < CLASSES; i++)
+            free_lists[i] = nullptr;
+    }
+    slab_pool(const slab_pool&) = delete;
+    slab_pool& operator=(const slab_pool&) = delete;
+    ~slab_pool() {
+        while (chunks) {
+            chunk* previous = chunks->previous;
+            ::operator delete(chunks);
+            chunks = previous;
+        }
+    }
+
+    void* allocate(size_t bytes, size_t align) {
+        if (bytes > MAX_BLOCK || align > GRAIN)
+            return ::operator new(bytes, std::align_val_t(align));
+        size_t index = bytes ? (bytes - 1) / GRAIN : 0;
+        if (free_block* block = free_lists[index]) {
+            free_lists[index] = block->next;
+            free_count--;
+            return block;
+        }
+        size_t size = (index + 1) * GRAIN;
+        if (size_t(limit - cursor) < size)
+            grow();
+        void* block = cursor;
+        cursor += size;
+        return block;
+    }
+    void deallocate(void* p, size_t bytes, size_t align) {
+        if (bytes > MAX_BLOCK || align > GRAIN) {
+            ::operator delete(p, std::align_val_t(align));
+            return;
+        }
+        size_t index = bytes ? (bytes - 1) / GRAIN : 0;
+        free_block* block = static_cast<free_block*>(p);
+        block->next = free_lists[index];
+        free_lists[index] = block;
+        free_count++;
+    }
+
+    /**
+     * chunks taken from operator new, and blocks waiting for reuse
+     */
+    size_t chunks_allocated() const { return chunk_count; }
+    size_t free_blocks() const { return free_count; }
+};
+
+/**
+ * an allocator on a slab_pool, for the Alloc parameter of the
+ * containers: nodes and values come from the pool, arrays from
+ * operator new. the pool must outlive every container using it.
+ */
+template <class T>
+class slab_allocator {
+   public:
+    using value_type = T;
+    slab_pool* pool;
+
+    slab_allocator(slab_pool* pool) : pool(pool) {}
+    template <class U>
+    slab_allocator(const slab_allocator<U>& other) : pool(other.pool) {}
+
+    T* allocate(size_t n) {
+        if (n == 1)
+            return static_cast<T*>(pool->allocate(sizeof(T), alignof(T)));
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t n) {
+        if (n == 1)
+            pool->deallocate(p, sizeof(T), alignof(T));
+        else
+            ::operator delete(p);
+    }
+    template <class U>
+    bool operator==(const slab_allocator<U>& other) const {
+        return pool == other.pool;
+    }
+    template <class U>
+    bool operator!=(const slab_allocator<U>& other) const {
+        return pool != other.pool;
+    }
+};
+
+/**
+ * e.g. slab_pool pool; slab_lru<int, Matrix<int>> cache(1000, &pool);
+ */
+template <class Key,
+          class Value,
+          class Hash = std::hash<Key>,
+          class Equal = std::equal_to<Key>>
+using slab_lru =
+    basic_lru<Key, Value, Hash, Equal, slab_allocator<pair<const Key, Value>>>;
+}  // namespace sjtu
+
+#endif
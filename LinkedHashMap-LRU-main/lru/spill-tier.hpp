@@ -0,0 +1,483 @@
+#ifndef SJTU_SPILL_TIER_HPP
+#define SJTU_SPILL_TIER_HPP
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "lru.hpp"
+#include "serialize.hpp"
+
+namespace sjtu {
+/**
+ * a victim tier on local disk (POSIX only)
+ * entries are appended to the active segment of a log of files in
+ * directory; a new segment is started once the active one holds
+ * segment_size bytes. an in-memory index maps every key to its
+ * newest record. taking or replacing a key leaves garbage behind in
+ * its old segment, and a sealed segment that is more than half
+ * garbage is compacted: its live records are copied to the active
+ * segment and the file is deleted. compaction runs on a background
+ * thread, or only through compact() when background is false.
+ * the same thread writes the records: put() only copies a record to
+ * memory, and the thread writes them out once FLUSH_BYTES are
+ * waiting or the segment is sealed; a take() of a record not written
+ * yet is served from memory. without the thread put() writes itself.
+ * with max_bytes set, a put() that makes the segments hold more than
+ * max_bytes deletes the oldest sealed segments and forgets their
+ * keys; the active segment is never deleted, so segment_size should
+ * be well below max_bytes.
+ * the tier is a cache as well: it starts empty (old segment files in
+ * directory are overwritten) and deletes its files when destroyed.
+ * record: u32 key length, u32 value length, key bytes, value bytes
+ * (serializer<T>), u64 FNV-1a of the key and value bytes
+ */
+template <class Key,
+          class Value,
+          class Hash = std::hash<Key>,
+          class Equal = std::equal_to<Key>>
+class spill_tier : public victim_tier<Key, Value> {
+    struct location {
+        size_t segment;
+        unsigned long long offset;
+        unsigned long long length;
+    };
+    struct segment {
+        int fd;
+        unsigned long long size;
+        unsigned long long live;
+        // bytes in the file, then writing (being written by the
+        // thread) and pending (not yet) up to size
+        unsigned long long written;
+        std::vector<char> writing;
+        std::vector<char> pending;
+        bool compacting;
+        bool dropped;
+    };
+    static constexpr size_t FLUSH_BYTES = 1 << 16;
+
+    std::string directory;
+    unsigned long long segment_size;
+    unsigned long long max_bytes;
+    // bytes of the segments not deleted
+    unsigned long long stored;
+    // keys in the order their records were appended, so also by
+    // segment number
+    linked_hashmap<Key, location, Hash, Equal> index;
+    // by number, fd is -1 once the segment is deleted
+    std::vector<segment> segments;
+    size_t active;
+    std::vector<char> buffer;
+    std::mutex lock;
+    std::condition_variable wake;
+    bool stopping;
+    // the thread failed, the tier keeps nothing any more
+    bool failed;
+    bool background;
+    std::thread compactor;
+
+    std::string name(size_t number) const {
+        return directory + "/segment-" + std::to_string(number) + ".log";
+    }
+    void open_segment() {
+        std::string path = name(segments.size());
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+            throw std::runtime_error("spill_tier: cannot create " + path);
+        segments.push_back(segment{fd, 0, 0, 0, {}, {}, false, false});
+        active = segments.size() - 1;
+    }
+    /**
+     * a sealed segment worth compacting, -1 if none
+     */
+    size_t candidate() const {
+        for (size_t i = 0; i < segments.size(); i++)
+            if (i != active && segments[i].fd >= 0 &&
+                !segments[i].compacting && !segments[i].dropped &&
+                segments[i].written == segments[i].size &&
+                segments[i].live * 2 < segments[i].size)
+                return i;
+        return size_t(-1);
+    }
+    /**
+     * a segment with records to write, -1 if none
+     */
+    size_t unwritten() const {
+        for (size_t i = 0; i < segments.size(); i++)
+            if (segments[i].fd >= 0 && segments[i].writing.empty() &&
+                !segments[i].pending.empty() &&
+                (i != active || segments[i].pending.size() >= FLUSH_BYTES))
+                return i;
+        return size_t(-1);
+    }
+    /**
+     * delete the file of a dropped or compacted segment, unless the
+     * thread still uses it: then the thread does when it is done
+     */
+    void release(size_t number) {
+        segment& s = segments[number];
+        if (s.compacting || !s.writing.empty())
+            return;
+        ::close(s.fd);
+        std::remove(name(number).c_str());
+        stored -= s.size;
+        segments[number] = segment{-1, 0, 0, 0, {}, {}, false, false};
+    }
+    /**
+     * delete the oldest sealed segment and forget its keys, which are
+     * the first ones of the index; false if every segment is active
+     */
+    bool drop_oldest() {
+        size_t number = 0;
+        while (number < active &&
+               (segments[number].fd < 0 || segments[number].dropped))
+            number++;
+        if (number >= active)
+            return false;
+        while (index.size() && index.begin()->second.segment == number)
+            index.remove(index.begin());
+        segment& s = segments[number];
+        stored -= s.size;
+        s.size = s.live = 0;
+        s.pending.clear();
+        s.dropped = true;
+        release(number);
+        return true;
+    }
+    void forget(const location& at) {
+        segments[at.segment].live -= at.length;
+        if (at.segment != active && segments[at.segment].live * 2 <
+                                        segments[at.segment].size)
+            wake.notify_one();
+    }
+    /**
+     * append a whole record to the active segment and index it
+     * called with lock held
+     */
+    void append(const Key& key, const char* record, unsigned long long len) {
+        segment& s = segments[active];
+        if (background) {
+            s.pending.insert(s.pending.end(), record, record + len);
+        } else {
+            if (::pwrite(s.fd, record, len, s.size) != (ssize_t)len)
+                throw std::runtime_error("spill_tier: write failed");
+            s.written += len;
+        }
+        location at{active, s.size, len};
+        s.size += len;
+        s.live += len;
+        stored += len;
+        auto iter = index.find(key);
+        if (iter != index.end()) {
+            forget(iter->second);
+            iter->second = at;
+            index.move_to_back(iter);
+        } else {
+            index.insert({key, at});
+        }
+        if (s.size >= segment_size) {
+            open_segment();
+            if (background)
+                wake.notify_one();
+        } else if (background && s.pending.size() >= FLUSH_BYTES) {
+            wake.notify_one();
+        }
+    }
+    bool read(const location& at, std::vector<char>& record) const {
+        const segment& s = segments[at.segment];
+        record.resize(at.length);
+        if (at.offset < s.written)
+            return ::pread(s.fd, record.data(), at.length, at.offset) ==
+                   (ssize_t)at.length;
+        // records are never split between writing and pending
+        unsigned long long from = at.offset - s.written;
+        if (from < s.writing.size()) {
+            std::memcpy(record.data(), s.writing.data() + from, at.length);
+        } else {
+            from -= s.writing.size();
+            std::memcpy(record.data(), s.pending.data() + from, at.length);
+        }
+        return true;
+    }
+    /**
+     * write the pending records of segment number without the lock;
+     * records that could not be written are lost, as if taken
+     */
+    void flush(size_t number, std::unique_lock<std::mutex>& guard) {
+        segment& s = segments[number];
+        s.writing.swap(s.pending);
+        int fd = s.fd;
+        const char* data = s.writing.data();
+        unsigned long long len = s.writing.size();
+        unsigned long long offset = s.written;
+        guard.unlock();
+        bool complete = ::pwrite(fd, data, len, offset) == (ssize_t)len;
+        guard.lock();
+        if (!complete) {
+            for (auto iter = index.begin(); iter != index.end();) {
+                auto next = iter;
+                ++next;
+                if (iter->second.segment == number &&
+                    iter->second.offset >= offset &&
+                    iter->second.offset < offset + len) {
+                    forget(iter->second);
+                    index.remove(iter);
+                }
+                iter = next;
+            }
+        }
+        segments[number].written += len;
+        segments[number].writing.clear();
+        if (segments[number].dropped)
+            release(number);
+    }
+    /**
+     * split a record, false if its checksum is wrong
+     */
+    static bool parse(const char* record,
+                      size_t size,
+                      const char*& key,
+                      unsigned& key_len,
+                      const char*& value,
+                      unsigned& value_len) {
+        const size_t head = 2 * sizeof(unsigned);
+        const size_t tail = sizeof(unsigned long long);
+        if (size < head + tail)
+            return false;
+        std::memcpy(&key_len, record, sizeof(unsigned));
+        std::memcpy(&value_len, record + sizeof(unsigned), sizeof(unsigned));
+        if (size != head + key_len + value_len + tail)
+            return false;
+        unsigned long long checksum;
+        std::memcpy(&checksum, record + head + key_len + value_len, tail);
+        key = record + head;
+        value = key + key_len;
+        return fnv1a(key, key_len + value_len) == checksum;
+    }
+    /**
+     * copy the live records of segment number to the active one,
+     * then delete it; the sealed segment never changes, so it is
+     * read without the lock. the records from the first one that is
+     * torn, fails its checksum or cannot be copied are lost.
+     */
+    void compact(size_t number, std::unique_lock<std::mutex>& guard) {
+        int fd = segments[number].fd;
+        unsigned long long size = segments[number].size;
+        segments[number].compacting = true;
+        guard.unlock();
+        std::vector<char> data(size);
+        bool complete = ::pread(fd, data.data(), size, 0) == (ssize_t)size;
+        guard.lock();
+        unsigned long long offset = 0;
+        const size_t head = 2 * sizeof(unsigned);
+        const size_t tail = sizeof(unsigned long long);
+        try {
+            while (complete && offset + head <= size) {
+                const char* record = data.data() + offset;
+                unsigned key_len, value_len;
+                std::memcpy(&key_len, record, sizeof(unsigned));
+                std::memcpy(&value_len, record + sizeof(unsigned),
+                            sizeof(unsigned));
+                unsigned long long len = head + key_len + value_len + tail;
+                const char *key_bytes, *value_bytes;
+                if (len > size - offset ||
+                    !parse(record, len, key_bytes, key_len, value_bytes,
+                           value_len))
+                    break;
+                Key key = serializer<Key>::read(key_bytes, key_len);
+                auto iter = index.find(key);
+                // only the newest record of a key is live
+                if (iter != index.end() && iter->second.segment == number &&
+                    iter->second.offset == offset)
+                    append(key, record, len);
+                offset += len;
+            }
+        } catch (...) {
+            // no room or no file for the copy
+        }
+        // whatever could not be read back is lost, as if taken
+        if (offset != size) {
+            for (auto iter = index.begin(); iter != index.end();) {
+                auto next = iter;
+                ++next;
+                if (iter->second.segment == number)
+                    index.remove(iter);
+                iter = next;
+            }
+        }
+        segments[number].compacting = false;
+        release(number);
+    }
+    void work() {
+        std::unique_lock<std::mutex> guard(lock);
+        while (true) {
+            wake.wait(guard, [this] {
+                return stopping || unwritten() != size_t(-1) ||
+                       candidate() != size_t(-1);
+            });
+            if (stopping)
+                return;
+            size_t number = unwritten();
+            bool writing = number != size_t(-1);
+            if (!writing)
+                number = candidate();
+            try {
+                if (writing)
+                    flush(number, guard);
+                else
+                    compact(number, guard);
+            } catch (...) {
+                // nothing may unwind the thread: give the tier up,
+                // every key is forgotten and the files go by compaction
+                if (!guard.owns_lock())
+                    guard.lock();
+                failed = true;
+                index.clear();
+                segments[number].compacting = false;
+                segments[number].writing.clear();
+                for (segment& s : segments)
+                    s.live = 0;
+            }
+        }
+    }
+
+   public:
+    /**
+     * directory must exist; segment_size and max_bytes are in bytes,
+     * max_bytes 0 for no bound
+     */
+    spill_tier(const std::string& directory,
+               unsigned long long segment_size = 64 << 20,
+               bool background = true,
+               unsigned long long max_bytes = 0)
+        : directory(directory),
+          segment_size(segment_size),
+          max_bytes(max_bytes),
+          stored(0),
+          stopping(false),
+          failed(false),
+          background(background) {
+        open_segment();
+        if (background)
+            compactor = std::thread([this] { work(); });
+    }
+    spill_tier(const spill_tier&) = delete;
+    spill_tier& operator=(const spill_tier&) = delete;
+    ~spill_tier() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        if (compactor.joinable())
+            compactor.join();
+        for (size_t i = 0; i < segments.size(); i++) {
+            if (segments[i].fd < 0)
+                continue;
+            ::close(segments[i].fd);
+            std::remove(name(i).c_str());
+        }
+    }
+
+    void put(const Key& key, const Value& value) override {
+        std::lock_guard<std::mutex> guard(lock);
+        if (failed)
+            return;
+        unsigned key_len = serializer<Key>::size(key);
+        unsigned value_len = serializer<Value>::size(value);
+        const size_t head = 2 * sizeof(unsigned);
+        buffer.resize(head + key_len + value_len + sizeof(unsigned long long));
+        char* at = buffer.data();
+        std::memcpy(at, &key_len, sizeof(unsigned));
+        std::memcpy(at + sizeof(unsigned), &value_len, sizeof(unsigned));
+        serializer<Key>::write(key, at + head);
+        serializer<Value>::write(value, at + head + key_len);
+        unsigned long long checksum = fnv1a(at + head, key_len + value_len);
+        std::memcpy(at + head + key_len + value_len, &checksum,
+                    sizeof(checksum));
+        append(key, buffer.data(), buffer.size());
+        while (max_bytes && stored > max_bytes && drop_oldest()) {
+        }
+    }
+    std::unique_ptr<Value> take(const Key& key) override {
+        std::lock_guard<std::mutex> guard(lock);
+        auto iter = index.find(key);
+        if (iter == index.end())
+            return nullptr;
+        location at = iter->second;
+        index.remove(iter);
+        forget(at);
+        std::vector<char> record;
+        const char *key_bytes, *value_bytes;
+        unsigned key_len, value_len;
+        if (!read(at, record) ||
+            !parse(record.data(), record.size(), key_bytes, key_len,
+                   value_bytes, value_len))
+            return nullptr;
+        return std::unique_ptr<Value>(
+            new Value(serializer<Value>::read(value_bytes, value_len)));
+    }
+    void erase(const Key& key) override {
+        std::lock_guard<std::mutex> guard(lock);
+        auto iter = index.find(key);
+        if (iter == index.end())
+            return;
+        forget(iter->second);
+        index.remove(iter);
+    }
+    /**
+     * compact every segment worth it now, return how many were
+     */
+    size_t compact() {
+        std::unique_lock<std::mutex> guard(lock);
+        size_t count = 0;
+        for (size_t number; (number = candidate()) != size_t(-1); count++)
+            compact(number, guard);
+        return count;
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> guard(lock);
+        return index.size();
+    }
+    /**
+     * false once the background thread failed: from then on the tier
+     * drops what it is given
+     */
+    bool good() {
+        std::lock_guard<std::mutex> guard(lock);
+        return !failed;
+    }
+    /**
+     * bytes in segment files (some maybe still in memory), and the
+     * part of them still indexed
+     */
+    unsigned long long disk_bytes() {
+        std::lock_guard<std::mutex> guard(lock);
+        return stored;
+    }
+    unsigned long long live_bytes() {
+        std::lock_guard<std::mutex> guard(lock);
+        unsigned long long total = 0;
+        for (const segment& s : segments)
+            total += s.live;
+        return total;
+    }
+    size_t segment_count() {
+        std::lock_guard<std::mutex> guard(lock);
+        size_t count = 0;
+        for (const segment& s : segments)
+            count += s.fd >= 0 && !s.dropped;
+        return count;
+    }
+};
+}  // namespace sjtu
+
+#endif
@@ -0,0 +1,221 @@
+#ifndef SJTU_STATIC_LRU_HPP
+#define SJTU_STATIC_LRU_HPP
+
+#include <cstddef>
+#include <new>
+#include "lru.hpp"
+
+namespace sjtu {
+/**
+ * an lru of at most N entries that never allocates: the entries, the
+ * bucket heads and every link are arrays inside the object, and the
+ * links are 32-bit slot numbers instead of pointers. meant for a
+ * per-thread cache or a cache on the stack of a hot loop (mind its
+ * size, about N * (sizeof(value_type) + 16) bytes).
+ * a slot is in the recency list (prev/next) while used, and in the
+ * free list (next) otherwise; chain links the slots of a bucket.
+ * the same save/get semantics as basic_lru, without weights,
+ * expiry or observers.
+ */
+template <class Key,
+          class Value,
+          size_t N,
+          class Hash = std::hash<Key>,
+          class Equal = std::equal_to<Key>>
+class static_lru {
+   public:
+    using key_arg = param_type<Key>;
+    using value_type = sjtu::pair<const Key, Value>;
+    using index = unsigned;
+    static constexpr index NIL = ~index(0);
+    static_assert(N > 0 && N < NIL, "N must fit in a 32-bit index");
+
+    /**
+     * the smallest power of two with N at most 3/4 of it, so that a
+     * bucket is found with a mask (of the hash passed through
+     * mix_hash)
+     */
+    static constexpr size_t bucket_count() {
+        size_t count = 1;
+        while (count * 3 < N * 4)
+            count *= 2;
+        return count;
+    }
+    static constexpr size_t BUCKETS = bucket_count();
+
+   private:
+    struct link {
+        index prev;
+        index next;
+        index chain;
+        unsigned hash;
+    };
+    alignas(value_type) unsigned char storage[N][sizeof(value_type)];
+    link links[N];
+    index buckets[BUCKETS];
+    index head;
+    index tail;
+    index free_head;
+    size_t count;
+    Hash hasher;
+    Equal equal;
+
+    value_type& entry(index i) {
+        return *std::launder(reinterpret_cast<value_type*>(storage[i]));
+    }
+    unsigned hash_of(const Key& key) const { return mix_hash(hasher(key)); }
+    index find(const Key& key, unsigned h) {
+        for (index i = buckets[h & (BUCKETS - 1)]; i != NIL;
+             i = links[i].chain)
+            if (links[i].hash == h && equal(entry(i).first, key))
+                return i;
+        return NIL;
+    }
+    void unlink(index i) {
+        link& l = links[i];
+        if (l.prev != NIL)
+            links[l.prev].next = l.next;
+        else
+            head = l.next;
+        if (l.next != NIL)
+            links[l.next].prev = l.prev;
+        else
+            tail = l.prev;
+    }
+    void push_back(index i) {
+        links[i].prev = tail;
+        links[i].next = NIL;
+        if (tail != NIL)
+            links[tail].next = i;
+        else
+            head = i;
+        tail = i;
+    }
+    /**
+     * drop the least recently used entry, its slot becomes free
+     */
+    void evict() {
+        index victim = head;
+        unlink(victim);
+        index* at = &buckets[links[victim].hash & (BUCKETS - 1)];
+        while (*at != victim)
+            at = &links[*at].chain;
+        *at = links[victim].chain;
+        entry(victim).~value_type();
+        links[victim].next = free_head;
+        free_head = victim;
+        count--;
+    }
+
+   public:
+    static_lru() { reset(); }
+    static_lru(const static_lru&) = delete;
+    static_lru& operator=(const static_lru&) = delete;
+    ~static_lru() { clear(); }
+
+    static constexpr size_t capacity() { return N; }
+    size_t size() const { return count; }
+    bool empty() const { return !count; }
+
+    /**
+     * save the value_pair, evicting the least recently used entry
+     * when all N slots are taken
+     */
+    void save(const value_type& v) {
+        unsigned h = hash_of(v.first);
+        index i = find(v.first, h);
+        if (i != NIL) {
+            entry(i).second = v.second;
+            unlink(i);
+            push_back(i);
+            return;
+        }
+        if (count == N)
+            evict();
+        i = free_head;
+        new (storage[i]) value_type(v);
+        free_head = links[i].next;
+        links[i].hash = h;
+        index& bucket = buckets[h & (BUCKETS - 1)];
+        links[i].chain = bucket;
+        bucket = i;
+        push_back(i);
+        count++;
+    }
+    /**
+     * return a pointer to the value, nullptr if key is not cached
+     * a hit makes the entry the most recently used
+     */
+    Value* get(key_arg key) {
+        index i = find(key, hash_of(key));
+        if (i == NIL)
+            return nullptr;
+        unlink(i);
+        push_back(i);
+        return &entry(i).second;
+    }
+    /**
+     * drop every entry
+     */
+    void clear() {
+        for (index i = head; i != NIL; i = links[i].next)
+            entry(i).~value_type();
+        reset();
+    }
+
+    /**
+     * call f(key, value) for every entry, from the least to the
+     * most recently used, without changing the order
+     */
+    template <class F>
+    void for_each(F&& f) {
+        for (index i = head; i != NIL; i = links[i].next)
+            f(entry(i).first, static_cast<const Value&>(entry(i).second));
+    }
+    void print() {
+        for_each([](const Key& key, const Value& value) {
+            print_key(std ::cout, key);
+            std ::cout << " " << value << '\n';
+        });
+        std ::cout.flush();
+    }
+    /**
+     * as hashmap::diagnostics(), capacity being BUCKETS
+     */
+    table_diagnostics diagnostics() const {
+        table_diagnostics d{count, BUCKETS, {}, 0, 0, 0, 0, 0, 0};
+        size_t non_empty = 0, walked = 0;
+        for (size_t b = 0; b < BUCKETS; b++) {
+            size_t len = 0;
+            for (index i = buckets[b]; i != NIL; i = links[i].chain)
+                len++;
+            if (len >= d.chains.size())
+                d.chains.resize(len + 1, 0);
+            d.chains[len]++;
+            non_empty += len != 0;
+            walked += len * (len + 1) / 2;
+            if (len > d.max_chain)
+                d.max_chain = len;
+        }
+        d.mean_chain = non_empty ? double(count) / non_empty : 0;
+        d.probes_hit = count ? double(walked) / count : 0;
+        d.probes_miss = double(count) / BUCKETS;
+        d.bucket_bytes = sizeof(buckets);
+        d.node_bytes = count * (sizeof(value_type) + sizeof(link));
+        return d;
+    }
+
+   private:
+    void reset() {
+        for (size_t b = 0; b < BUCKETS; b++)
+            buckets[b] = NIL;
+        for (size_t i = 0; i < N; i++)
+            links[i].next = i + 1 < N ? index(i + 1) : NIL;
+        head = tail = NIL;
+        free_head = 0;
+        count = 0;
+    }
+};
+}  // namespace sjtu
+
+#endif
@@ -0,0 +1,213 @@
+#ifndef SJTU_TIMER_WHEEL_HPP
+#define SJTU_TIMER_WHEEL_HPP
+
+#include <chrono>
+#include <cstddef>
+
+namespace sjtu {
+/**
+ * where the caches read the time from, in ticks
+ * tests can pass a manual_clock to drive the time themselves
+ */
+class ttl_clock {
+   public:
+    virtual ~ttl_clock() {}
+    virtual unsigned long long now() const = 0;
+};
+
+/**
+ * milliseconds of std::chrono::steady_clock
+ */
+class steady_ttl_clock : public ttl_clock {
+   public:
+    unsigned long long now() const override {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+    static steady_ttl_clock* instance() {
+        static steady_ttl_clock clock;
+        return &clock;
+    }
+};
+
+class manual_clock : public ttl_clock {
+    unsigned long long ticks;
+
+   public:
+    manual_clock(unsigned long long start = 0) : ticks(start) {}
+    unsigned long long now() const override { return ticks; }
+    void advance(unsigned long long delta) { ticks += delta; }
+    void set(unsigned long long t) { ticks = t; }
+};
+
+/**
+ * hierarchical timer wheel: LEVELS wheels of SLOTS slots each,
+ * the wheel of level l covers SLOTS^(l+1) ticks. a timer sits in the
+ * lowest level that covers its distance and is moved one level down
+ * (cascaded) when the lower wheel wraps around to its slot, so both
+ * scheduling and cancelling are O(1) and advancing is O(1) amortized.
+ */
+template <class Key>
+class timer_wheel {
+   public:
+    static constexpr int BITS = 6;
+    static constexpr int LEVELS = 4;
+    static constexpr unsigned long long SLOTS = 1ull << BITS;
+    static constexpr unsigned long long MASK = SLOTS - 1;
+
+    class link {
+       public:
+        link* prev;
+        link* next;
+        link() : prev(this), next(this) {}
+    };
+    class timer : public link {
+       public:
+        Key key;
+        unsigned long long deadline;
+        int level;
+        timer(const Key& key, unsigned long long deadline)
+            : key(key), deadline(deadline), level(0) {}
+    };
+
+   private:
+    link slots[LEVELS][SLOTS];
+    size_t level_count[LEVELS];
+    size_t count;
+    // every tick up to (and including) current has been processed
+    unsigned long long current;
+
+    void unlink(timer* t) {
+        t->prev->next = t->next;
+        t->next->prev = t->prev;
+        t->prev = t->next = t;
+        level_count[t->level]--;
+        count--;
+    }
+    void place(timer* t) {
+        unsigned long long due = t->deadline > current ? t->deadline
+                                                       : current + 1;
+        unsigned long long delta = due - current;
+        int level = 0;
+        while (level < LEVELS - 1 && delta >= (1ull << (BITS * (level + 1))))
+            level++;
+        unsigned long long index;
+        if (delta >= (1ull << (BITS * LEVELS)))
+            // too far away: park in the slot visited last, re-placed later
+            index = (current >> (BITS * level)) & MASK;
+        else
+            index = (due >> (BITS * level)) & MASK;
+        link* head = &slots[level][index];
+        t->level = level;
+        t->prev = head->prev;
+        t->next = head;
+        head->prev->next = t;
+        head->prev = t;
+        level_count[level]++;
+        count++;
+    }
+    void cascade(int level, unsigned long long index) {
+        // detach the slot first: a far timer may land in it again
+        link* head = &slots[level][index];
+        if (head->next == head)
+            return;
+        link* t = head->next;
+        head->prev->next = nullptr;
+        head->prev = head->next = head;
+        while (t) {
+            link* next = t->next;
+            level_count[level]--;
+            count--;
+            place(static_cast<timer*>(t));
+            t = next;
+        }
+    }
+
+   public:
+    timer_wheel(unsigned long long start = 0) : count(0), current(start) {
+        for (int i = 0; i < LEVELS; i++)
+            level_count[i] = 0;
+    }
+    timer_wheel(const timer_wheel&) = delete;
+    timer_wheel& operator=(const timer_wheel&) = delete;
+    ~timer_wheel() { clear(); }
+
+    size_t size() const { return count; }
+    bool empty() const { return !count; }
+    unsigned long long time() const { return current; }
+
+    /**
+     * the returned timer belongs to the wheel until it is cancelled
+     * or handed to the callback of advance()
+     */
+    timer* schedule(const Key& key, unsigned long long deadline) {
+        timer* t = new timer(key, deadline);
+        place(t);
+        return t;
+    }
+    void reschedule(timer* t, unsigned long long deadline) {
+        unlink(t);
+        t->deadline = deadline;
+        place(t);
+    }
+    void cancel(timer* t) {
+        unlink(t);
+        delete t;
+    }
+    void clear() {
+        for (int i = 0; i < LEVELS; i++) {
+            for (unsigned long long j = 0; j < SLOTS; j++) {
+                link* head = &slots[i][j];
+                while (head->next != head)
+                    cancel(static_cast<timer*>(head->next));
+            }
+        }
+    }
+    /**
+     * process every tick up to now, on_expire(timer*) is called for
+     * each timer whose deadline has passed, then the timer is deleted
+     * returns how many timers expired
+     */
+    template <class F>
+    size_t advance(unsigned long long now, F&& on_expire) {
+        size_t expired = 0;
+        while (current < now) {
+            if (!count) {
+                current = now;
+                break;
+            }
+            // nothing can fire before the lowest busy wheel turns
+            int level = 0;
+            while (!level_count[level])
+                level++;
+            if (level) {
+                unsigned long long span = 1ull << (BITS * level);
+                unsigned long long boundary = (current | (span - 1)) + 1;
+                if (boundary > now) {
+                    current = now;
+                    break;
+                }
+                current = boundary - 1;
+            }
+            current++;
+            for (int l = 1; l < LEVELS; l++) {
+                if ((current >> (BITS * (l - 1))) & MASK)
+                    break;
+                cascade(l, (current >> (BITS * l)) & MASK);
+            }
+            link* head = &slots[0][current & MASK];
+            while (head->next != head) {
+                timer* t = static_cast<timer*>(head->next);
+                unlink(t);
+                on_expire(t);
+                delete t;
+                expired++;
+            }
+        }
+        return expired;
+    }
+};
+}  // namespace sjtu
+
+#endif
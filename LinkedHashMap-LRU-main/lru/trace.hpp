@@ -0,0 +1,237 @@
+#ifndef SJTU_TRACE_HPP
+#define SJTU_TRACE_HPP
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "lru.hpp"
+#include "serialize.hpp"
+
+namespace sjtu {
+/**
+ * trace layout: 8 bytes magic, then one record per access
+ *   u8 event, varint nanoseconds since the previous record,
+ *   varint key length, key bytes (serializer<Key>)
+ * evictions are not recorded, they depend on the cache replaying
+ */
+constexpr char TRACE_MAGIC[8] = {'S', 'J', 'T', 'R',
+                                 'A', 'C', 'E', '1'};
+
+/**
+ * writes the accesses of the cache it observes to a trace file
+ * cache.set_observer(&recorder) starts the recording; a write that
+ * fails (a full disk) is remembered, check good() before trusting
+ * or replaying the trace
+ */
+template <class Key>
+class trace_recorder : public access_observer<Key> {
+    using event = typename access_observer<Key>::event;
+    std::FILE* out;
+    std::vector<char> buffer;
+    std::chrono::steady_clock::time_point last;
+    size_t count;
+    bool failed;
+
+    void put_varint(unsigned long long v) {
+        while (v >= 0x80) {
+            buffer.push_back(char(v | 0x80));
+            v >>= 7;
+        }
+        buffer.push_back(char(v));
+    }
+
+   public:
+    explicit trace_recorder(const std::string& path)
+        : last(std::chrono::steady_clock::now()), count(0), failed(false) {
+        out = std::fopen(path.c_str(), "wb");
+        if (!out)
+            throw std::runtime_error("cannot write trace " + path);
+        buffer.assign(TRACE_MAGIC, TRACE_MAGIC + sizeof(TRACE_MAGIC));
+    }
+    trace_recorder(const trace_recorder&) = delete;
+    trace_recorder& operator=(const trace_recorder&) = delete;
+    ~trace_recorder() {
+        flush();
+        std::fclose(out);
+    }
+
+    void on_access(event e, const Key& key) override {
+        if (e == access_observer<Key>::evict)
+            return;
+        auto now = std::chrono::steady_clock::now();
+        buffer.push_back(char(e));
+        put_varint(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now - last)
+                .count());
+        last = now;
+        size_t len = serializer<Key>::size(key);
+        put_varint(len);
+        size_t at = buffer.size();
+        buffer.resize(at + len);
+        serializer<Key>::write(key, buffer.data() + at);
+        count++;
+        if (buffer.size() >= (1 << 16))
+            flush();
+    }
+    /**
+     * write the buffered records, false (and good() false from then
+     * on) if they could not all be written
+     */
+    bool flush() {
+        if (std::fwrite(buffer.data(), 1, buffer.size(), out) !=
+                buffer.size() ||
+            std::fflush(out))
+            failed = true;
+        buffer.clear();
+        return !failed;
+    }
+    size_t records() const { return count; }
+    /**
+     * every record so far reached the file, or is still buffered
+     */
+    bool good() const { return !failed; }
+};
+
+/**
+ * call f(event, nanoseconds since the first record, key) for every
+ * record of the trace at path, return the number of records
+ * throws std::runtime_error if it is not a complete trace
+ */
+template <class Key, class F>
+size_t read_trace(const std::string& path, F f) {
+    // the buffer outlives the file, which is closed however f leaves
+    std::vector<char> io(1 << 20);
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> file(
+        std::fopen(path.c_str(), "rb"), &std::fclose);
+    if (!file)
+        throw std::runtime_error("cannot read trace " + path);
+    std::FILE* in = file.get();
+    std::setvbuf(in, io.data(), _IOFBF, io.size());
+    // no key is longer than what is left of the file
+    long size = -1;
+    if (!std::fseek(in, 0, SEEK_END))
+        size = std::ftell(in);
+    if (size < 0 || std::fseek(in, 0, SEEK_SET))
+        throw std::runtime_error("cannot read trace " + path);
+    auto broken = [&path]() {
+        return std::runtime_error("broken trace " + path);
+    };
+    auto get_varint = [in](unsigned long long& v) {
+        v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            int c = std::getc(in);
+            if (c == EOF)
+                return false;
+            v |= (unsigned long long)(c & 0x7f) << shift;
+            if (!(c & 0x80))
+                return true;
+        }
+        return false;
+    };
+    char magic[sizeof(TRACE_MAGIC)];
+    if (std::fread(magic, 1, sizeof(magic), in) != sizeof(magic) ||
+        std::memcmp(magic, TRACE_MAGIC, sizeof(magic)))
+        throw broken();
+    std::vector<char> key;
+    // a key of the wrong length is a broken record too
+    auto decode = [&key, &broken](size_t len) {
+        try {
+            return serializer<Key>::read(key.data(), len);
+        } catch (const std::runtime_error&) {
+            throw broken();
+        }
+    };
+    unsigned long long time = 0, delta, len;
+    size_t count = 0;
+    int e;
+    while ((e = std::getc(in)) != EOF) {
+        if (e > access_observer<Key>::miss || !get_varint(delta) ||
+            !get_varint(len) ||
+            len > (unsigned long long)(size - std::ftell(in)))
+            throw broken();
+        key.resize(len);
+        if (std::fread(key.data(), 1, len, in) != len)
+            throw broken();
+        time += delta;
+        f(typename access_observer<Key>::event(e), time, decode(len));
+        count++;
+    }
+    return count;
+}
+
+/**
+ * what a cache did with a trace
+ */
+struct replay_report {
+    size_t saves = 0;
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    double seconds = 0;
+
+    double hit_ratio() const {
+        return hits + misses ? double(hits) / (hits + misses) : 0;
+    }
+    /**
+     * accesses per second, the time of reading the trace excluded
+     */
+    double throughput() const {
+        return seconds > 0 ? (saves + hits + misses) / seconds : 0;
+    }
+};
+
+/**
+ * run the trace at path against cache (a basic_lru or an arc with
+ * any bounds): gets are replayed as gets, saves save make_value(key)
+ * the trace is read first, then the accesses are timed. the observer
+ * of cache is replaced for the replay and put back afterwards, also
+ * when an access throws.
+ */
+template <class Key, class Cache, class Make>
+replay_report replay(const std::string& path, Cache& cache, Make make_value) {
+    using event = typename access_observer<Key>::event;
+    std::vector<char> events;
+    std::vector<Key> keys;
+    read_trace<Key>(path, [&](event e, unsigned long long, const Key& key) {
+        events.push_back(char(e));
+        keys.push_back(key);
+    });
+
+    struct counter : access_observer<Key> {
+        replay_report report;
+        void on_access(event e, const Key&) override {
+            if (e == access_observer<Key>::save)
+                report.saves++;
+            else if (e == access_observer<Key>::hit)
+                report.hits++;
+            else if (e == access_observer<Key>::miss)
+                report.misses++;
+            else
+                report.evictions++;
+        }
+    } counted;
+    using value_type = typename Cache::value_type;
+    struct restore {
+        Cache& cache;
+        access_observer<Key>* previous;
+        ~restore() { cache.set_observer(previous); }
+    } guard{cache, cache.set_observer(&counted)};
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (events[i] == access_observer<Key>::save)
+            cache.save(value_type(keys[i], make_value(keys[i])));
+        else
+            cache.get(keys[i]);
+    }
+    std::chrono::duration<double> spent =
+        std::chrono::steady_clock::now() - start;
+    counted.report.seconds = spent.count();
+    return counted.report;
+}
+}  // namespace sjtu
+
+#endif
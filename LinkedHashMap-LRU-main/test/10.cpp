@@ -0,0 +1,116 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: default weight",
+    "test2: update changes the weight",
+    "test3: user weigher",
+    "test4: entry heavier than the budget",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+size_t unit_weight(const Integer&, const Matrix<int>&){
+    return 1;
+}
+
+void fail(){
+    std::cout<<c[1]<<std::endl;
+    exit(0);
+}
+
+void weighted_lru_tester(){
+    using value_type = sjtu::pair<Integer,Matrix<int> >;
+    const size_t budget = 64 * 64 * sizeof(int);
+
+    //test: matrices from 2x2 to 64x64 under a budget of one 64x64 matrix
+    std::cout<<c[2]<<std::endl;
+    {
+        sjtu::lru tester(1000, budget);
+        for(int i=0;i<1000;i++){
+            int n = 2 + (i * 7) % 63;
+            tester.save(value_type(Integer(i),Matrix<int>(n,n,i)));
+            if(tester.weight() > budget)
+                fail();
+        }
+        size_t total = 0;
+        for(int i=0;i<1000;i++){
+            int n = 2 + (i * 7) % 63;
+            Matrix<int> *res = tester.get(Integer(i));
+            if(res){
+                if(!((*res) == Matrix<int>(n,n,i)))
+                    fail();
+                total += n * n * sizeof(int);
+            }
+        }
+        if(total != tester.weight())
+            fail();
+        std::cout<<tester.size()<<" "<<tester.weight()<<std::endl;
+    }
+
+    //test: saving a smaller matrix under the same key releases weight
+    std::cout<<c[3]<<std::endl;
+    {
+        sjtu::lru tester(10, budget);
+        tester.save(value_type(Integer(0),Matrix<int>(32,32,0)));
+        tester.save(value_type(Integer(1),Matrix<int>(32,32,1)));
+        std::cout<<tester.size()<<" "<<tester.weight()<<std::endl;
+        tester.save(value_type(Integer(0),Matrix<int>(2,2,0)));
+        std::cout<<tester.size()<<" "<<tester.weight()<<std::endl;
+        tester.save(value_type(Integer(2),Matrix<int>(60,60,2)));
+        std::cout<<tester.size()<<" "<<tester.weight()<<std::endl;
+        if(tester.get(Integer(1)) || !tester.get(Integer(0)))
+            fail();
+    }
+
+    //test: a weigher that counts entries behaves like the plain lru
+    std::cout<<c[4]<<std::endl;
+    {
+        sjtu::lru tester(1000, 100, unit_weight);
+        for(int i=0;i<10000;i++){
+            tester.save(value_type(Integer(i),Matrix<int>(2,2,i)));
+            tester.get(Integer(i-(i%99)));
+        }
+        std::cout<<tester.size()<<" "<<tester.weight()<<std::endl;
+        // a lambda with state
+        size_t calls = 0;
+        sjtu::lru counted(10, 5, [&calls](const Integer&, const Matrix<int>&){
+            calls++;
+            return size_t(1);
+        });
+        for(int i=0;i<20;i++)
+            counted.save(value_type(Integer(i),Matrix<int>(2,2,i)));
+        std::cout<<counted.size()<<" "<<calls<<std::endl;
+    }
+
+    //test: an entry heavier than the whole budget is not kept, the others stay
+    std::cout<<c[5]<<std::endl;
+    {
+        sjtu::lru tester(10, budget);
+        tester.save(value_type(Integer(0),Matrix<int>(2,2,0)));
+        tester.save(value_type(Integer(1),Matrix<int>(65,65,1)));
+        if(tester.get(Integer(1)) || !tester.get(Integer(0)))
+            fail();
+        std::cout<<tester.size()<<" "<<tester.weight()<<std::endl;
+        // too heavy an update drops the old value of that key only
+        tester.save(value_type(Integer(2),Matrix<int>(2,2,2)));
+        tester.save(value_type(Integer(2),Matrix<int>(65,65,2)));
+        if(tester.get(Integer(2)) || !tester.get(Integer(0)))
+            fail();
+        std::cout<<tester.size()<<" "<<tester.weight()<<std::endl;
+    }
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("10.out","w",stdout);
+#endif
+    weighted_lru_tester();
+    std::cout << c[6] << std::endl;
+}
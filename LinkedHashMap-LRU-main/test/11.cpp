@@ -0,0 +1,147 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: expire after write",
+    "test2: expire after access",
+    "test3: per-entry ttl and cleanup",
+    "test4: random ttls against a brute force",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void fail(int line){
+    std::cout<<c[1]<<" "<<line<<std::endl;
+    exit(0);
+}
+
+unsigned int seed = 19260817;
+unsigned int next_rand(){
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 8) & 0xffffff;
+}
+
+void ttl_lru_tester(){
+    using value_type = sjtu::pair<Integer,Matrix<int> >;
+
+    //test: entries written at t and t+50 with a ttl of 100
+    std::cout<<c[2]<<std::endl;
+    {
+        sjtu::manual_clock clock(1000);
+        sjtu::lru tester(100);
+        tester.set_clock(&clock);
+        tester.set_expire_after_write(100);
+        for(int i=0;i<10;i++)
+            tester.save(value_type(Integer(i),Matrix<int>(2,2,i)));
+        clock.advance(50);
+        for(int i=10;i<20;i++)
+            tester.save(value_type(Integer(i),Matrix<int>(2,2,i)));
+        clock.advance(49);
+        if(!tester.get(Integer(0))) fail(__LINE__);
+        clock.advance(1);
+        if(tester.get(Integer(0)) || tester.get(Integer(9))) fail(__LINE__);
+        if(!tester.get(Integer(10))) fail(__LINE__);
+        std::cout<<tester.size()<<std::endl;
+        // a new write restarts the ttl
+        tester.save(value_type(Integer(10),Matrix<int>(2,2,-10)));
+        clock.advance(50);
+        if(tester.get(Integer(11)) || !tester.get(Integer(10))) fail(__LINE__);
+        std::cout<<tester.size()<<std::endl;
+    }
+
+    //test: only the entries that are read keep living
+    std::cout<<c[3]<<std::endl;
+    {
+        sjtu::manual_clock clock;
+        sjtu::lru tester(100);
+        tester.set_clock(&clock);
+        tester.set_expire_after_access(30);
+        for(int i=0;i<10;i++)
+            tester.save(value_type(Integer(i),Matrix<int>(2,2,i)));
+        for(int t=0;t<10;t++){
+            clock.advance(20);
+            for(int i=0;i<4;i++)
+                if(!tester.get(Integer(i))) fail(__LINE__);
+        }
+        std::cout<<tester.size()<<std::endl;
+        // a write ttl caps how long reads can keep an entry
+        tester.set_expire_after_write(50);
+        tester.save(value_type(Integer(5),Matrix<int>(2,2,5)));
+        for(int t=0;t<3;t++){
+            clock.advance(20);
+            if((tester.get(Integer(5)) != nullptr) != (t < 2)) fail(__LINE__);
+        }
+    }
+
+    //test: a long ttl spans several wheels, cleanup() removes without access
+    std::cout<<c[4]<<std::endl;
+    {
+        sjtu::manual_clock clock(123456789);
+        sjtu::lru tester(100);
+        tester.set_clock(&clock);
+        tester.save(value_type(Integer(0),Matrix<int>(2,2,0)));
+        tester.save(value_type(Integer(1),Matrix<int>(2,2,1)),5);
+        tester.save(value_type(Integer(2),Matrix<int>(2,2,2)),10000000);
+        tester.save(value_type(Integer(3),Matrix<int>(2,2,3)),100000000);
+        clock.advance(5);
+        std::cout<<tester.cleanup()<<" "<<tester.size()<<std::endl;
+        clock.advance(10000000 - 6);
+        std::cout<<tester.cleanup()<<" "<<tester.size()<<std::endl;
+        clock.advance(1);
+        std::cout<<tester.cleanup()<<" "<<tester.size()<<std::endl;
+        clock.advance(100000000);
+        std::cout<<tester.cleanup()<<" "<<tester.size()<<std::endl;
+        if(!tester.get(Integer(0))) fail(__LINE__);
+    }
+
+    //test: random writes and time steps, checked against stored deadlines
+    std::cout<<c[5]<<std::endl;
+    {
+        const int n = 500;
+        unsigned long long deadline[n];
+        for(int i=0;i<n;i++)
+            deadline[i] = 0;
+        sjtu::manual_clock clock(777);
+        sjtu::lru tester(n);
+        tester.set_clock(&clock);
+        int alive = 0;
+        for(int round=0;round<200000;round++){
+            int key = next_rand() % n;
+            unsigned int op = next_rand() % 8;
+            if(op == 0){
+                clock.advance(next_rand() % 50);
+            }else if(op == 7){
+                clock.advance(next_rand() % 5000);
+            }else if(op < 4){
+                unsigned int bits = next_rand() % 22;
+                unsigned long long ttl = 1 + next_rand() % (1u << bits);
+                tester.save(value_type(Integer(key),Matrix<int>(1,1,key)),ttl);
+                deadline[key] = clock.now() + ttl;
+            }else{
+                bool expected = deadline[key] > clock.now();
+                if((tester.get(Integer(key)) != nullptr) != expected) fail(__LINE__);
+                alive += expected;
+            }
+        }
+        int live = 0;
+        for(int i=0;i<n;i++)
+            live += deadline[i] > clock.now();
+        tester.cleanup();
+        if(live != (int)tester.size()) fail(__LINE__);
+        std::cout<<alive<<" "<<live<<std::endl;
+    }
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("11.out","w",stdout);
+#endif
+    ttl_lru_tester();
+    std::cout << c[6] << std::endl;
+}
@@ -0,0 +1,115 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: string keys",
+    "test2: pod keys and values",
+    "test3: custom hash and equal",
+    "test4: memcheck",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void fail(int line){
+    std::cout<<c[1]<<" "<<line<<std::endl;
+    exit(0);
+}
+
+struct point{
+    int x,y;
+};
+struct point_hash{
+    size_t operator()(const point &p) const {
+        return p.x * 31 + p.y;
+    }
+};
+struct point_equal{
+    bool operator()(const point &a,const point &b) const {
+        return a.x == b.x && a.y == b.y;
+    }
+};
+std::ostream &operator<<(std::ostream &os,const point &p){
+    return os<<"("<<p.x<<","<<p.y<<")";
+}
+
+void generic_lru_tester(){
+    //test: std::string -> std::string
+    std::cout<<c[2]<<std::endl;
+    {
+        using cache = sjtu::basic_lru<std::string,std::string>;
+        using value_type = cache::value_type;
+        cache tester(5);
+        for(int i=0;i<20;i++){
+            tester.save(value_type("key" + std::to_string(i % 8),"value" + std::to_string(i)));
+            tester.get("key" + std::to_string(i % 3));
+        }
+        std::string *res = tester.get("key2");
+        if(!res || *res != "value18") fail(__LINE__);
+        tester.print();
+    }
+
+    //test: int -> double, keys and values passed by value
+    std::cout<<c[3]<<std::endl;
+    {
+        using cache = sjtu::basic_lru<int,double>;
+        using value_type = cache::value_type;
+        static_assert(std::is_same<cache::key_arg,int>::value,"int keys go by value");
+        static_assert(std::is_same<sjtu::basic_lru<std::string,int>::key_arg,const std::string&>::value,"strings go by reference");
+        static_assert(std::is_same<cache::value_arg,double>::value,"double values go by value");
+        static_assert(std::is_same<sjtu::lru::value_arg,const Matrix<int>&>::value,"matrices go by reference");
+        cache tester(100, 100 * sizeof(double));
+        double sum = 0;
+        for(int i=0;i<100000;i++){
+            if(i % 2)
+                tester.save(value_type(i,i * 0.5));
+            else
+                tester.save(i,i * 0.5);
+            double *res = tester.get(i - (i % 77));
+            if(!res || *res != (i - (i % 77)) * 0.5) fail(__LINE__);
+            sum += *res;
+        }
+        std::cout<<tester.size()<<" "<<tester.weight()<<" "<<(long long)sum<<std::endl;
+    }
+
+    //test: user types with their own hash and equal
+    std::cout<<c[4]<<std::endl;
+    {
+        using cache = sjtu::basic_lru<point,Matrix<int>,point_hash,point_equal>;
+        using value_type = cache::value_type;
+        cache tester(4);
+        for(int i=0;i<6;i++)
+            tester.save(value_type(point{i,-i},Matrix<int>(1,2,i)));
+        if(tester.get(point{1,-1}) || !tester.get(point{2,-2})) fail(__LINE__);
+        tester.print();
+    }
+
+    //test: no Integer survives the caches
+    std::cout<<c[5]<<std::endl;
+    {
+        int before = Integer::counter;
+        {
+            sjtu::lru tester(50);
+            using value_type = sjtu::pair<Integer,Matrix<int> >;
+            for(int i=0;i<1000;i++){
+                tester.save(value_type(Integer(i % 70),Matrix<int>(2,2,i)));
+                tester.save(Integer(i % 71),Matrix<int>(1,1,i));
+                tester.get(Integer(i % 13));
+            }
+        }
+        if(Integer::counter != before) fail(__LINE__);
+    }
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("12.out","w",stdout);
+#endif
+    generic_lru_tester();
+    std::cout << c[6] << std::endl;
+}
@@ -0,0 +1,164 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: one loader per missing key",
+    "test2: a failed load reaches every waiter",
+    "test3: single thread",
+    "test4: copies and a failed save",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void fail(int line){
+    std::cout<<c[1]<<" "<<line<<std::endl;
+    exit(0);
+}
+
+void single_flight_tester(){
+    const int threads = 8;
+    const int keys = 50;
+
+    //test: 8 threads ask for the same 50 slow keys
+    std::cout<<c[2]<<std::endl;
+    {
+        using cache = sjtu::basic_lru<int,Matrix<int> >;
+        cache tester(keys);
+        std::atomic<int> calls[keys];
+        for(int i=0;i<keys;i++)
+            calls[i] = 0;
+        std::atomic<bool> wrong(false);
+        std::vector<std::thread> pool;
+        for(int t=0;t<threads;t++){
+            pool.emplace_back([&,t](){
+                for(int round=0;round<3;round++){
+                    for(int i=0;i<keys;i++){
+                        int key = (i + t) % keys;
+                        Matrix<int> res = tester.get_or_load(key,[&](int k){
+                            calls[k]++;
+                            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                            return Matrix<int>(2,2,k);
+                        });
+                        if(!(res == Matrix<int>(2,2,key)))
+                            wrong = true;
+                    }
+                }
+            });
+        }
+        for(auto &th : pool)
+            th.join();
+        if(wrong) fail(__LINE__);
+        int total = 0;
+        for(int i=0;i<keys;i++){
+            if(calls[i] != 1) fail(__LINE__);
+            total += calls[i];
+        }
+        std::cout<<total<<" "<<tester.size()<<std::endl;
+    }
+
+    //test: every waiter of a failing load sees the exception, a retry loads again
+    std::cout<<c[3]<<std::endl;
+    {
+        using cache = sjtu::basic_lru<int,int>;
+        cache tester(10);
+        std::atomic<int> calls(0), errors(0), arrived(0);
+        auto broken = [&](int){
+            calls++;
+            while(arrived != threads)
+                std::this_thread::yield();
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            throw std::runtime_error("load failed");
+            return 0;
+        };
+        std::vector<std::thread> pool;
+        for(int t=0;t<threads;t++){
+            pool.emplace_back([&](){
+                try{
+                    arrived++;
+                    tester.get_or_load(7,broken);
+                }catch(const std::runtime_error &){
+                    errors++;
+                }
+            });
+        }
+        for(auto &th : pool)
+            th.join();
+        if(calls != 1 || errors != threads) fail(__LINE__);
+        int res = tester.get_or_load(7,[](int k){ return k * 3; });
+        std::cout<<calls<<" "<<errors<<" "<<res<<" "<<tester.size()<<std::endl;
+    }
+
+    //test: without contention it is get + save
+    std::cout<<c[4]<<std::endl;
+    {
+        sjtu::lru tester(3);
+        int calls = 0;
+        auto loader = [&](const Integer &k){
+            calls++;
+            return Matrix<int>(1,1,k.val);
+        };
+        for(int i=0;i<10;i++)
+            tester.get_or_load(Integer(i % 4),loader);
+        std::cout<<calls<<std::endl;
+        tester.print();
+    }
+
+    //test: a copy has the entries in order, not the counters nor the lock
+    std::cout<<c[5]<<std::endl;
+    {
+        static_assert(std::is_copy_constructible<sjtu::lru>::value && std::is_copy_assignable<sjtu::lru>::value,"lru is copyable");
+        using cache = sjtu::basic_lru<int,Matrix<int> >;
+        cache tester(20);
+        tester.set_hot_fraction(0.5);
+        for(int i=0;i<30;i++)
+            tester.save(cache::value_type(i,Matrix<int>(4,4,i)));
+        tester.save(cache::value_type(100,Matrix<int>(4,4,100)),1000000);
+        tester.get(15);
+        cache copy(tester);
+        if(copy.stats().hits || copy.stats().inserts) fail(__LINE__);
+        if(copy.size() != tester.size() || copy.cold_size() != tester.cold_size()) fail(__LINE__);
+        if(copy.weight() != tester.weight()) fail(__LINE__);
+        std::string a, b;
+        tester.for_each([&a](int k, const Matrix<int> &v){ a += std::to_string(k) + ":" + std::to_string(v[0][0]) + " "; });
+        copy.for_each([&b](int k, const Matrix<int> &v){ b += std::to_string(k) + ":" + std::to_string(v[0][0]) + " "; });
+        if(a != b) fail(__LINE__);
+        copy.save(cache::value_type(15,Matrix<int>(1,1,-1)));
+        if((*tester.get(15))[0][0] != 15) fail(__LINE__);
+        cache assigned(1);
+        assigned = copy;
+        if(assigned.size() != 20 || (*assigned.get(15))[0][0] != -1) fail(__LINE__);
+        std::cout<<copy.size()<<" "<<copy.cold_size()<<" "<<assigned.get_or_load(500,[](int k){ return Matrix<int>(1,1,k); })[0][0]<<std::endl;
+
+        // the save after a successful loader throws: one failure only
+        sjtu::basic_lru<int,int> strict(10, 100, [](const int &, const int &v) -> size_t {
+            if(v < 0) throw std::runtime_error("negative");
+            return 1;
+        });
+        try{
+            strict.get_or_load(1,[](int){ return -1; });
+        }catch(const std::runtime_error &){
+        }
+        sjtu::cache_stats st = strict.stats();
+        std::cout<<st.load_successes<<" "<<st.load_failures<<std::endl;
+        if(st.load_successes != 0 || st.load_failures != 1) fail(__LINE__);
+    }
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("13.out","w",stdout);
+#endif
+    single_flight_tester();
+    std::cout << c[6] << std::endl;
+}
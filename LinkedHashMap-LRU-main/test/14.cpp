@@ -0,0 +1,123 @@
+#include "src.hpp"
+#include "async-lru.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: misses share one pending load",
+    "test2: completed loads are plain hits",
+    "test3: failed loads",
+    "test4: an executor running the load itself",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void fail(int line){
+    std::cout<<c[1]<<" "<<line<<std::endl;
+    exit(0);
+}
+
+/**
+ * runs every task in submit(), as a caller-runs pool does
+ */
+struct inline_executor {
+    int tasks = 0;
+    template <class F>
+    void submit(F &&f){
+        tasks++;
+        f();
+    }
+};
+
+void async_lru_tester(){
+    using cache = sjtu::async_lru<int,Matrix<int> >;
+    const int n = 40;
+    sjtu::thread_pool pool(4);
+    cache tester(100,pool);
+    std::atomic<int> calls(0);
+    auto loader = [&](int k){
+        calls++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        return Matrix<int>(2,2,k);
+    };
+
+    //test: three gets of every key before anything is loaded
+    std::cout<<c[2]<<std::endl;
+    {
+        std::vector<cache::future> first, second;
+        for(int i=0;i<n;i++){
+            first.push_back(tester.get(i,loader));
+            second.push_back(tester.get(i,loader));
+            tester.get(i,loader);
+        }
+        for(int i=0;i<n;i++){
+            if(!(first[i].get() == Matrix<int>(2,2,i))) fail(__LINE__);
+            if(&first[i].get() != &second[i].get()) fail(__LINE__);
+        }
+        tester.wait();
+        std::cout<<calls<<" "<<tester.size()<<" "<<tester.loading()<<std::endl;
+    }
+
+    //test: the values went through save(), gets are ready at once
+    std::cout<<c[3]<<std::endl;
+    {
+        for(int i=0;i<n;i++){
+            cache::future f = tester.get(i,loader);
+            if(f.wait_for(std::chrono::seconds(0)) != std::future_status::ready) fail(__LINE__);
+            if(!(f.get() == Matrix<int>(2,2,i))) fail(__LINE__);
+        }
+        Matrix<int> out;
+        if(!tester.try_get(3,out) || !(out == Matrix<int>(2,2,3))) fail(__LINE__);
+        if(tester.try_get(n,out)) fail(__LINE__);
+        std::cout<<calls<<std::endl;
+    }
+
+    //test: an exception is shared, nothing is cached, the next get retries
+    std::cout<<c[4]<<std::endl;
+    {
+        std::atomic<int> broken_calls(0);
+        auto broken = [&](int) -> Matrix<int> {
+            broken_calls++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            throw std::runtime_error("load failed");
+        };
+        cache::future a = tester.get(-1,broken);
+        cache::future b = tester.get(-1,broken);
+        int errors = 0;
+        try{ a.get(); }catch(const std::runtime_error &){ errors++; }
+        try{ b.get(); }catch(const std::runtime_error &){ errors++; }
+        tester.wait();
+        if(!(tester.get(-1,loader).get() == Matrix<int>(2,2,-1))) fail(__LINE__);
+        std::cout<<broken_calls<<" "<<errors<<" "<<tester.size()<<std::endl;
+    }
+
+    //test: the load runs inside get(), the future is ready on return
+    std::cout<<c[5]<<std::endl;
+    {
+        inline_executor here;
+        sjtu::async_lru<int,Matrix<int>,std::hash<int>,std::equal_to<int>,inline_executor> local(10,here);
+        for(int i=0;i<20;i++){
+            cache::future f = local.get(i % 12,[](int k){ return Matrix<int>(1,1,k); });
+            if(f.wait_for(std::chrono::seconds(0)) != std::future_status::ready) fail(__LINE__);
+            if(!(f.get() == Matrix<int>(1,1,i % 12))) fail(__LINE__);
+        }
+        if(local.loading()) fail(__LINE__);
+        std::cout<<here.tasks<<" "<<local.size()<<std::endl;
+    }
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("14.out","w",stdout);
+#endif
+    async_lru_tester();
+    std::cout << c[6] << std::endl;
+}
@@ -0,0 +1,109 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <vector>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: save_many against save",
+    "test2: get_many against get",
+    "test3: large pod batches",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void fail(int line){
+    std::cout<<c[1]<<" "<<line<<std::endl;
+    exit(0);
+}
+
+unsigned int seed = 998244353;
+int next_rand(){
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 8) & 0xffffff;
+}
+
+void batch_lru_tester(){
+    using value_type = sjtu::pair<Integer,Matrix<int> >;
+    const int n = 1000;
+    sjtu::lru batched(n), single(n);
+
+    //test: batches of random sizes, keys repeat inside a batch
+    std::cout<<c[2]<<std::endl;
+    for(int round=0;round<200;round++){
+        int len = next_rand() % 257;
+        std::vector<value_type> values;
+        for(int i=0;i<len;i++){
+            int key = next_rand() % (2 * n);
+            values.push_back(value_type(Integer(key),Matrix<int>(2,2,round)));
+        }
+        batched.save_many(values.data(),values.size());
+        for(int i=0;i<len;i++)
+            single.save(values[i]);
+        if(batched.size() != single.size()) fail(__LINE__);
+    }
+    std::cout<<batched.size()<<std::endl;
+
+    //test: lookups mixing hits and misses, the order moves the same way
+    std::cout<<c[3]<<std::endl;
+    int hits = 0;
+    for(int round=0;round<200;round++){
+        int len = next_rand() % 257;
+        std::vector<Integer> keys;
+        for(int i=0;i<len;i++)
+            keys.push_back(Integer(next_rand() % (2 * n)));
+        std::vector<Matrix<int>*> out(len);
+        hits += batched.get_many(keys.data(),keys.size(),out.data());
+        for(int i=0;i<len;i++){
+            Matrix<int> *res = single.get(keys[i]);
+            if((res == nullptr) != (out[i] == nullptr)) fail(__LINE__);
+            if(res && !(*res == *out[i])) fail(__LINE__);
+        }
+        if(round % 10 == 0){
+            value_type v(Integer(round),Matrix<int>(1,1,round));
+            batched.save_many(&v,1);
+            single.save(v);
+        }
+    }
+    for(int i=0;i<2*n;i++){
+        Matrix<int> *a = batched.get(Integer(i)), *b = single.get(Integer(i));
+        if((a == nullptr) != (b == nullptr)) fail(__LINE__);
+    }
+    std::cout<<hits<<std::endl;
+
+    //test: 65536 pod values in one batch, then twice as many lookups
+    std::cout<<c[4]<<std::endl;
+    {
+        sjtu::basic_lru<int,int> small(1 << 20), check(1 << 20);
+        using pod_value = sjtu::basic_lru<int,int>::value_type;
+        std::vector<pod_value> values;
+        for(int i=0;i<(1 << 16);i++)
+            values.push_back(pod_value(i * 7,i));
+        small.save_many(values.data(),values.size());
+        for(auto &v : values)
+            check.save(v);
+        std::vector<int> keys;
+        for(int i=0;i<(1 << 17);i++)
+            keys.push_back(i);
+        std::vector<int*> out(keys.size());
+        size_t found = small.get_many(keys.data(),keys.size(),out.data());
+        for(size_t i=0;i<keys.size();i++){
+            int *res = check.get(keys[i]);
+            if((res == nullptr) != (out[i] == nullptr)) fail(__LINE__);
+            if(res && *res != *out[i]) fail(__LINE__);
+        }
+        std::cout<<found<<" "<<small.size()<<std::endl;
+    }
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("15.out","w",stdout);
+#endif
+    batch_lru_tester();
+    std::cout << c[5] << std::endl;
+}
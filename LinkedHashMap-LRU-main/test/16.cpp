@@ -0,0 +1,103 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: shrink and grow at runtime",
+    "test2: watermarks evict in batches",
+    "test3: weight watermarks",
+    "test4: remove through dual",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void fail(int line){
+    std::cout<<c[1]<<" "<<line<<std::endl;
+    exit(0);
+}
+
+void capacity_lru_tester(){
+    using value_type = sjtu::pair<Integer,Matrix<int> >;
+
+    //test: 1000 -> 10 keeps the 10 most recent, 10 -> 500 keeps everything
+    std::cout<<c[2]<<std::endl;
+    {
+        sjtu::lru tester(1000);
+        for(int i=0;i<1000;i++)
+            tester.save(value_type(Integer(i),Matrix<int>(1,1,i)));
+        tester.get(Integer(3));
+        tester.set_capacity(10);
+        std::cout<<tester.size()<<" "<<tester.capacity()<<std::endl;
+        tester.print();
+        tester.set_capacity(500);
+        for(int i=0;i<600;i++)
+            tester.save(value_type(Integer(i),Matrix<int>(1,1,i)));
+        if(tester.size() != 500 || tester.get(Integer(99)) || !tester.get(Integer(100))) fail(__LINE__);
+        std::cout<<tester.size()<<std::endl;
+    }
+
+    //test: high 100, low 80: the size saws between 80 and 100
+    std::cout<<c[3]<<std::endl;
+    {
+        sjtu::lru tester(100);
+        tester.set_capacity(100,80);
+        size_t lowest = 1000, highest = 0;
+        int batches = 0;
+        for(int i=0;i<1000;i++){
+            size_t before = tester.size();
+            tester.save(value_type(Integer(i),Matrix<int>(1,1,i)));
+            if(tester.size() < before) batches++;
+            if(i >= 100){
+                lowest = tester.size() < lowest ? tester.size() : lowest;
+                highest = tester.size() > highest ? tester.size() : highest;
+            }
+        }
+        std::cout<<lowest<<" "<<highest<<" "<<batches<<std::endl;
+        // the survivors are still the most recent keys
+        for(int i=999;i>999-(int)tester.size();i--)
+            if(!tester.get(Integer(i))) fail(__LINE__);
+    }
+
+    //test: a weight budget of 100 matrices of 4 ints, low mark of 50
+    std::cout<<c[4]<<std::endl;
+    {
+        sjtu::lru tester(1000);
+        tester.set_max_weight(100 * 4 * sizeof(int),50 * 4 * sizeof(int));
+        for(int i=0;i<250;i++){
+            tester.save(value_type(Integer(i),Matrix<int>(2,2,i)));
+            if(tester.weight() > 100 * 4 * sizeof(int)) fail(__LINE__);
+        }
+        std::cout<<tester.size()<<" "<<tester.weight()<<std::endl;
+    }
+
+    //test: linked_hashmap::remove keeps the buckets consistent
+    std::cout<<c[5]<<std::endl;
+    {
+        sjtu::linked_hashmap<int,int> map;
+        for(int i=0;i<1000;i++)
+            map.insert(sjtu::pair<const int,int>(i,i));
+        for(int i=0;i<1000;i+=3)
+            map.remove(map.find(i));
+        int count = 0;
+        for(int i=0;i<1000;i++){
+            if(map.count(i) != (i % 3 != 0)) fail(__LINE__);
+            count += map.count(i);
+        }
+        for(int i=0;i<1000;i+=3)
+            map.insert(sjtu::pair<const int,int>(i,-i));
+        std::cout<<count<<" "<<map.size()<<" "<<map.at(999)<<std::endl;
+    }
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("16.out","w",stdout);
+#endif
+    capacity_lru_tester();
+    std::cout << c[6] << std::endl;
+}
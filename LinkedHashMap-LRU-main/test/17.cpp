@@ -0,0 +1,193 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: a snapshot restores entries and order",
+    "test2: a smaller cache keeps the most recent entries",
+    "test3: broken snapshots are rejected",
+    "test4: string keys and values",
+    "test5: other types and lying records are rejected",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void fail(int line){
+    std::cout<<c[1]<<" "<<line<<std::endl;
+    exit(0);
+}
+
+const char *path = "17.snapshot";
+unsigned int seed = 2333;
+int next_rand(){
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 16) & 0x7fff;
+}
+
+Matrix<int> random_matrix(){
+    int rows = next_rand() % 5;
+    int cols = next_rand() % 5;
+    Matrix<int> m(rows,cols);
+    for(int i=0;i<rows;i++)
+        for(int j=0;j<cols;j++)
+            m[i][j] = next_rand() - 16384;
+    return m;
+}
+
+void snapshot_tester(){
+    using value_type = sjtu::pair<Integer,Matrix<int> >;
+    sjtu::lru origin(200);
+    for(int i=0;i<1000;i++){
+        int key = next_rand() % 300;
+        if(next_rand() % 3){
+            Matrix<int> m = random_matrix();
+            origin.save(value_type(Integer(key),m));
+        }else{
+            origin.get(Integer(key));
+        }
+    }
+    origin.save_snapshot(path);
+
+    //test: the same entries in the same order, and the same evictions later
+    std::cout<<c[2]<<std::endl;
+    {
+        sjtu::lru restored(200);
+        restored.save(value_type(Integer(-1),Matrix<int>(1,1,-1)));
+        if(restored.load_snapshot(path) != origin.size()) fail(__LINE__);
+        if(restored.size() != origin.size() || restored.weight() != origin.weight()) fail(__LINE__);
+        if(restored.get(Integer(-1))) fail(__LINE__);
+        for(int i=0;i<500;i++){
+            int key = next_rand() % 400;
+            Matrix<int> *a = origin.get(Integer(key));
+            Matrix<int> *b = restored.get(Integer(key));
+            if(!a != !b || (a && !(*a == *b))) fail(__LINE__);
+            if(next_rand() % 2){
+                Matrix<int> m(1,1,i);
+                origin.save(value_type(Integer(key + 300),m));
+                restored.save(value_type(Integer(key + 300),m));
+            }
+        }
+        std::cout<<restored.size()<<" "<<restored.weight()<<std::endl;
+        origin.save_snapshot(path);
+    }
+
+    //test: only the most recent entries fit
+    std::cout<<c[3]<<std::endl;
+    {
+        sjtu::lru small(5);
+        if(small.load_snapshot(path) != 5) fail(__LINE__);
+        small.print();
+    }
+
+    //test: a wrong byte, a cut file, another file and no file
+    std::cout<<c[4]<<std::endl;
+    {
+        std::string good;
+        {
+            std::ifstream in(path,std::ios::binary);
+            good.assign(std::istreambuf_iterator<char>(in),std::istreambuf_iterator<char>());
+        }
+        std::string broken[] = {good,good.substr(0,good.size() - 3),good};
+        broken[0][good.size() / 2] ^= 1;
+        broken[2][0] = 'X';
+        sjtu::lru tester(10);
+        tester.save(value_type(Integer(1),Matrix<int>(1,1,1)));
+        int errors = 0;
+        for(int i=0;i<3;i++){
+            {
+                std::ofstream out(path,std::ios::binary);
+                out<<broken[i];
+            }
+            try{
+                tester.load_snapshot(path);
+            }catch(const std::runtime_error &){
+                errors++;
+            }
+        }
+        std::remove(path);
+        try{
+            tester.load_snapshot(path);
+        }catch(const std::runtime_error &){
+            errors++;
+        }
+        if(tester.size() != 1 || !tester.get(Integer(1))) fail(__LINE__);
+        std::cout<<errors<<std::endl;
+    }
+
+    //test: variable length keys
+    std::cout<<c[5]<<std::endl;
+    {
+        using cache = sjtu::basic_lru<std::string,std::string>;
+        using pair = cache::value_type;
+        cache a(4), b(4);
+        a.save(pair("",""));
+        for(int i=0;i<4;i++)
+            a.save(pair(std::string(i,'k'),"value" + std::to_string(i)));
+        a.get("");
+        a.save_snapshot(path);
+        b.load_snapshot(path);
+        b.print();
+        std::remove(path);
+    }
+
+    //test: a snapshot of int -> int, and a matrix claiming more rows than its record holds
+    std::cout<<c[6]<<std::endl;
+    {
+        using ints = sjtu::basic_lru<int,int>;
+        ints other(10);
+        other.save(ints::value_type(1,2));
+        other.save_snapshot(path);
+        sjtu::lru tester(10);
+        tester.save(value_type(Integer(1),Matrix<int>(1,1,1)));
+        int errors = 0;
+        try{
+            tester.load_snapshot(path);
+        }catch(const std::runtime_error &){
+            errors++;
+        }
+        sjtu::lru one(10);
+        one.save(value_type(Integer(5),Matrix<int>(1,1,5)));
+        one.save(value_type(Integer(6),Matrix<int>(1,1,6)));
+        one.save_snapshot(path);
+        std::string data;
+        {
+            std::ifstream in(path,std::ios::binary);
+            data.assign(std::istreambuf_iterator<char>(in),std::istreambuf_iterator<char>());
+        }
+        // header, key length, key, value length, then the rows
+        unsigned long long rows = 1000;
+        std::memcpy(&data[32 + 4 + 4 + 4],&rows,sizeof(rows));
+        // with a checksum that matches
+        unsigned long long sum = sjtu::fnv1a(data.data() + 32,data.size() - 40);
+        std::memcpy(&data[data.size() - 8],&sum,sizeof(sum));
+        {
+            std::ofstream out(path,std::ios::binary);
+            out<<data;
+        }
+        try{
+            tester.load_snapshot(path);
+        }catch(const std::runtime_error &){
+            errors++;
+        }
+        if(tester.size() != 1 || !tester.get(Integer(1))) fail(__LINE__);
+        std::cout<<errors<<std::endl;
+        std::remove(path);
+    }
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("17.out","w",stdout);
+#endif
+    snapshot_tester();
+    std::cout << c[7] << std::endl;
+}
@@ -0,0 +1,199 @@
+#include "src.hpp"
+#include "mapped-hashmap.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: the same as linked_hashmap",
+    "test2: reopened maps keep content and order",
+    "test3: an lru on a mapped file",
+    "test4: foreign and damaged files are rejected",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void fail(int line){
+    std::cout<<c[1]<<" "<<line<<std::endl;
+    exit(0);
+}
+
+const char *path = "18.map";
+unsigned int seed = 1926;
+int next_rand(){
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 16) & 0x7fff;
+}
+
+struct record{
+    int id;
+    double score;
+};
+using mapped = sjtu::mapped_hashmap<int,record>;
+using memory = sjtu::linked_hashmap<int,record>;
+
+bool same(mapped &a,memory &b){
+    if(a.size() != b.size()) return false;
+    auto j = b.begin();
+    for(auto i = a.begin(); i != a.end(); i++, j++){
+        if(i->first != j->first || i->second.id != j->second.id || i->second.score != j->second.score)
+            return false;
+    }
+    return j == b.end();
+}
+
+void random_ops(mapped &a,memory &b,int n){
+    for(int i=0;i<n;i++){
+        int op = next_rand() % 4;
+        int key = next_rand() % 3000;
+        if(op < 2){
+            record r = {key,next_rand() * 0.25};
+            if(a.insert({key,r}).second != b.insert({key,r}).second) fail(__LINE__);
+        }else if(op == 2){
+            if(a.count(key) != b.count(key)) fail(__LINE__);
+            if(a.count(key)){
+                a.remove(a.find(key));
+                b.remove(b.find(key));
+            }
+        }else{
+            if(a.count(key)){
+                a.move_to_back(a.find(key));
+                b.move_to_back(b.find(key));
+            }
+        }
+    }
+}
+
+void mapped_tester(){
+    std::remove(path);
+    memory model;
+
+    //test: random inserts, updates, removes and moves
+    std::cout<<c[2]<<std::endl;
+    {
+        mapped tester(path);
+        if(!tester.empty()) fail(__LINE__);
+        auto first = tester.insert({-1,record{-1,0}}).first;
+        random_ops(tester,model,50000);
+        // offsets survive the growth of the file
+        if(first->first != -1) fail(__LINE__);
+        tester.remove(first);
+        if(!same(tester,model)) fail(__LINE__);
+        std::cout<<tester.size()<<" "<<tester.capacity()<<std::endl;
+    }
+
+    //test: mapped again, then changed again
+    std::cout<<c[3]<<std::endl;
+    {
+        mapped tester(path);
+        if(!same(tester,model)) fail(__LINE__);
+        random_ops(tester,model,20000);
+        if(!same(tester,model)) fail(__LINE__);
+        tester.flush();
+    }
+    {
+        mapped tester(path);
+        if(!same(tester,model)) fail(__LINE__);
+        auto last = tester.end();
+        --last;
+        std::cout<<tester.size()<<" "<<last->first<<" "<<tester.at(last->first).id<<std::endl;
+        tester.clear();
+        if(!tester.empty() || tester.begin() != tester.end()) fail(__LINE__);
+    }
+    {
+        mapped tester(path);
+        if(!tester.empty()) fail(__LINE__);
+        tester.insert({7,record{7,7.5}});
+        std::cout<<tester.size()<<" "<<tester.at(7).score<<std::endl;
+    }
+
+    //test: keep the 3 most recently used keys across runs
+    std::cout<<c[4]<<std::endl;
+    {
+        std::remove(path);
+        int keys[] = {1,2,3,1,4,5,1,6};
+        for(int run=0;run<2;run++){
+            mapped cache(path);
+            for(int i=run*4;i<run*4+4;i++){
+                auto iter = cache.find(keys[i]);
+                if(iter != cache.end()){
+                    cache.move_to_back(iter);
+                    continue;
+                }
+                cache.insert({keys[i],record{keys[i],0}});
+                if(cache.size() > 3)
+                    cache.remove(cache.begin());
+            }
+        }
+        mapped cache(path);
+        for(auto it = cache.begin(); it != cache.end(); ++it)
+            std::cout<<it->first<<" ";
+        std::cout<<std::endl;
+    }
+
+    //test: another value type, and a file of garbage
+    std::cout<<c[5]<<std::endl;
+    {
+        int errors = 0;
+        try{
+            sjtu::mapped_hashmap<int,long long> other(path);
+        }catch(const std::runtime_error &){
+            errors++;
+        }
+        // offsets out of the file: the head of the history, a bucket
+        std::string data;
+        {
+            mapped good(path);
+            good.clear();
+            for(int i=0;i<10;i++)
+                good.insert({i,record{i,0}});
+        }
+        {
+            std::ifstream in(path,std::ios::binary);
+            data.assign(std::istreambuf_iterator<char>(in),std::istreambuf_iterator<char>());
+        }
+        unsigned long long far = 1ull << 40, buckets;
+        std::memcpy(&buckets,&data[32],sizeof(buckets));
+        for(int i=0;i<2;i++){
+            std::string broken = data;
+            std::memcpy(&broken[i ? buckets : 48],&far,sizeof(far));
+            {
+                std::ofstream out(path,std::ios::binary);
+                out<<broken;
+            }
+            try{
+                mapped other(path);
+            }catch(const std::runtime_error &){
+                errors++;
+            }
+        }
+        {
+            std::ofstream out(path,std::ios::binary);
+            for(int i=0;i<100;i++)
+                out<<"not a map ";
+        }
+        try{
+            mapped other(path);
+        }catch(const std::runtime_error &){
+            errors++;
+        }
+        std::remove(path);
+        std::cout<<errors<<std::endl;
+    }
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("18.out","w",stdout);
+#endif
+    mapped_tester();
+    std::cout << c[6] << std::endl;
+}
@@ -0,0 +1,124 @@
+#include "src.hpp"
+#include "export.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <sstream>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: for_each keeps the order",
+    "test2: text",
+    "test3: csv",
+    "test4: binary",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void fail(int line){
+    std::cout<<c[1]<<" "<<line<<std::endl;
+    exit(0);
+}
+
+void export_tester(){
+    using value_type = sjtu::pair<Integer,Matrix<int> >;
+    sjtu::lru tester(1000);
+    for(int i=0;i<3000;i++){
+        Matrix<int> m(i % 3,2,i);
+        if(i % 3)
+            m[0][1] = -i;
+        tester.save(value_type(Integer(i * 7 % 1100),m));
+        tester.get(Integer(i % 50));
+    }
+
+    //test: the visitor sees print() order and does not change it
+    std::cout<<c[2]<<std::endl;
+    {
+        std::ostringstream first, second;
+        int count = 0;
+        long long sum = 0;
+        tester.for_each([&](const Integer &key,const Matrix<int> &value){
+            first<<key.val<<" ";
+            count++;
+            sum += value.RowSize();
+        });
+        tester.for_each([&](const Integer &key,const Matrix<int> &){
+            second<<key.val<<" ";
+        });
+        if(first.str() != second.str() || count != (int)tester.size()) fail(__LINE__);
+        std::cout<<count<<" "<<sum<<std::endl;
+    }
+
+    //test: the text dump of the five most recent entries
+    std::cout<<c[3]<<std::endl;
+    {
+        sjtu::lru small(5);
+        tester.for_each([&](const Integer &key,const Matrix<int> &value){
+            small.save(value_type(key,value));
+        });
+        sjtu::dump<sjtu::text_format>(small,std::cout);
+        std::ostringstream whole;
+        sjtu::dump<sjtu::text_format>(tester,whole);
+        int lines = 0;
+        for(char ch : whole.str())
+            lines += ch == '\n';
+        if(lines != (int)tester.size()) fail(__LINE__);
+    }
+
+    //test: quoted strings and matrix fields
+    std::cout<<c[4]<<std::endl;
+    {
+        using cache = sjtu::basic_lru<std::string,double>;
+        cache strings(10);
+        strings.save(cache::value_type("plain",0.5));
+        strings.save(cache::value_type("a,b",-2));
+        strings.save(cache::value_type("say \"hi\"",1e20));
+        std::ostringstream out;
+        sjtu::dump<sjtu::csv_format>(strings,out);
+        sjtu::lru small(2);
+        small.save(value_type(Integer(3),Matrix<int>(2,2,9)));
+        small.save(value_type(Integer(4),Matrix<int>()));
+        sjtu::dump<sjtu::csv_format>(small,out);
+        std::string text = out.str();
+        for(char &ch : text)
+            if(ch == '\r') ch = '|';
+        std::cout<<text;
+    }
+
+    //test: a binary dump decodes into the same entries
+    std::cout<<c[5]<<std::endl;
+    {
+        std::ostringstream out;
+        sjtu::dump<sjtu::binary_format>(tester,out);
+        std::string data = out.str();
+        const char *in = data.data(), *end = data.data() + data.size();
+        sjtu::lru copy(1000);
+        while(in < end){
+            unsigned len;
+            std::memcpy(&len,in,sizeof(len));
+            Integer key = sjtu::serializer<Integer>::read(in + sizeof(len),len);
+            in += sizeof(len) + len;
+            std::memcpy(&len,in,sizeof(len));
+            Matrix<int> value = sjtu::serializer<Matrix<int> >::read(in + sizeof(len),len);
+            in += sizeof(len) + len;
+            copy.save(value_type(key,value));
+        }
+        if(in != end) fail(__LINE__);
+        std::ostringstream a, b;
+        sjtu::dump<sjtu::text_format>(tester,a);
+        sjtu::dump<sjtu::text_format>(copy,b);
+        if(a.str() != b.str()) fail(__LINE__);
+        std::cout<<copy.size()<<" "<<data.size()<<std::endl;
+    }
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("19.out","w",stdout);
+#endif
+    export_tester();
+    std::cout << c[6] << std::endl;
+}
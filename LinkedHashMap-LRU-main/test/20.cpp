@@ -0,0 +1,175 @@
+#include "src.hpp"
+#include "trace.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <sys/resource.h>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: recording a workload",
+    "test2: replaying it on the same cache",
+    "test3: other sizes and arc",
+    "test4: broken traces, throwing callbacks",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void fail(int line){
+    std::cout<<c[1]<<" "<<line<<std::endl;
+    exit(0);
+}
+
+const char *path = "20.trace";
+unsigned int seed = 4399;
+int next_rand(){
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 16) & 0x7fff;
+}
+
+Matrix<int> make_value(const Integer &key){
+    return Matrix<int>(1,1,key.val);
+}
+
+void trace_tester(){
+    using value_type = sjtu::pair<Integer,Matrix<int> >;
+    const int n = 30000;
+    size_t live_hits = 0, live_misses = 0;
+
+    //test: read-through workload, a hot set and a long tail
+    std::cout<<c[2]<<std::endl;
+    {
+        sjtu::lru tester(100);
+        sjtu::trace_recorder<Integer> recorder(path);
+        tester.set_observer(&recorder);
+        for(int i=0;i<n;i++){
+            int r = next_rand();
+            int key = r % 4 ? r % 150 : r % 2000;
+            if(tester.get(Integer(key))){
+                live_hits++;
+            }else{
+                live_misses++;
+                tester.save(value_type(Integer(key),make_value(Integer(key))));
+            }
+        }
+        tester.set_observer(nullptr);
+        tester.get(Integer(0));
+        std::cout<<recorder.records()<<" "<<live_hits<<" "<<live_misses<<std::endl;
+    }
+    {
+        size_t records = 0, gets = 0;
+        unsigned long long last = 0;
+        bool ordered = true;
+        records = sjtu::read_trace<Integer>(path,[&](sjtu::access_observer<Integer>::event e,unsigned long long time,const Integer &){
+            if(e != sjtu::access_observer<Integer>::save) gets++;
+            if(time < last) ordered = false;
+            last = time;
+        });
+        if(!ordered || gets != n) fail(__LINE__);
+        std::cout<<records<<std::endl;
+    }
+
+    //test: the same cache gives the same hits
+    std::cout<<c[3]<<std::endl;
+    {
+        sjtu::lru tester(100);
+        sjtu::replay_report report = sjtu::replay<Integer>(path,tester,make_value);
+        if(report.hits != live_hits || report.misses != live_misses) fail(__LINE__);
+        if(report.throughput() <= 0) fail(__LINE__);
+        std::cout<<report.saves<<" "<<report.hits<<" "<<report.misses<<" "<<report.evictions<<" "<<tester.size()<<std::endl;
+    }
+
+    //test: a bigger lru never hits less, arc on the same trace
+    std::cout<<c[4]<<std::endl;
+    {
+        size_t last = 0;
+        for(int size : {25,50,100,200,400,1600}){
+            sjtu::lru tester(size);
+            sjtu::replay_report report = sjtu::replay<Integer>(path,tester,make_value);
+            if(report.hits < last) fail(__LINE__);
+            last = report.hits;
+            std::cout<<size<<" "<<report.hits<<" "<<report.evictions<<" "<<(int)(report.hit_ratio() * 1000)<<std::endl;
+        }
+        sjtu::arc<Integer,Matrix<int>,Hash,Equal> other(100);
+        sjtu::replay_report report = sjtu::replay<Integer>(path,other,make_value);
+        if(report.hits + report.misses != n) fail(__LINE__);
+        std::cout<<"arc "<<report.hits<<" "<<report.evictions<<std::endl;
+    }
+
+    //test: cut and foreign files
+    std::cout<<c[5]<<std::endl;
+    {
+        std::string data;
+        {
+            std::FILE *in = std::fopen(path,"rb");
+            char buffer[4096];
+            size_t len;
+            while((len = std::fread(buffer,1,sizeof(buffer),in)) > 0)
+                data.append(buffer,len);
+            std::fclose(in);
+        }
+        // a callback leaving by an exception closes the file each time,
+        // more times than a leaking reader could open it
+        struct rlimit files, few;
+        getrlimit(RLIMIT_NOFILE,&files);
+        few = files;
+        few.rlim_cur = 64;
+        setrlimit(RLIMIT_NOFILE,&few);
+        int thrown = 0;
+        for(int i=0;i<100;i++){
+            try{
+                sjtu::read_trace<Integer>(path,[i](sjtu::access_observer<Integer>::event,unsigned long long,const Integer &){ throw i; });
+            }catch(int){
+                thrown++;
+            }
+        }
+        setrlimit(RLIMIT_NOFILE,&files);
+        // and the observer of the cache comes back after a failed replay
+        struct none : sjtu::access_observer<Integer> {
+            void on_access(event,const Integer &) override {}
+        } before;
+        sjtu::lru tester(10);
+        tester.set_observer(&before);
+        try{
+            sjtu::replay<Integer>(path,tester,[](const Integer &) -> Matrix<int> { throw std::runtime_error("no value"); });
+        }catch(const std::runtime_error &){
+            thrown++;
+        }
+        if(tester.set_observer(nullptr) != &before) fail(__LINE__);
+        std::cout<<thrown<<std::endl;
+        int errors = 0;
+        // a key length far past the end, and a key of 3 bytes
+        std::string huge = data.substr(0,8) + std::string("\x01\x00\xff\xff\xff\xff\xff\xff\xff\x7f",10) + "abcd";
+        std::string odd = data.substr(0,8) + std::string("\x01\x00\x03xyz",6);
+        std::string broken[] = {data.substr(0,data.size() - 2),"SJLRUSNP" + data.substr(8),huge,odd};
+        for(const std::string &b : broken){
+            std::FILE *out = std::fopen(path,"wb");
+            std::fwrite(b.data(),1,b.size(),out);
+            std::fclose(out);
+            try{
+                sjtu::read_trace<Integer>(path,[](sjtu::access_observer<Integer>::event,unsigned long long,const Integer &){});
+            }catch(const std::runtime_error &){
+                errors++;
+            }
+        }
+        std::remove(path);
+        // a full disk is reported, not silently cut
+        sjtu::trace_recorder<Integer> full("/dev/full");
+        full.on_access(sjtu::access_observer<Integer>::hit,Integer(1));
+        bool written = full.flush();
+        std::cout<<errors<<" "<<written<<" "<<full.good()<<std::endl;
+    }
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("20.out","w",stdout);
+#endif
+    trace_tester();
+    std::cout << c[6] << std::endl;
+}
@@ -0,0 +1,148 @@
+#include "src.hpp"
+#include "mrc.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: every key sampled gives the exact curve",
+    "test2: a 10% sample",
+    "test3: sizing the cache for a target",
+    "test4: a bounded sample, shared with another observer",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void fail(int line){
+    std::cout<<c[1]<<" "<<line<<std::endl;
+    exit(0);
+}
+
+unsigned int seed = 8192;
+int next_rand(){
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 16) & 0x7fff;
+}
+
+using value_type = sjtu::pair<Integer,Matrix<int> >;
+using estimator = sjtu::mrc_estimator<Integer,Hash,Equal>;
+const int n = 60000;
+int workload[n];
+
+/**
+ * a read-through cache: get, save on a miss
+ * return the hits
+ */
+int run(sjtu::lru &cache){
+    int hits = 0;
+    for(int i=0;i<n;i++){
+        if(cache.get(Integer(workload[i]))){
+            hits++;
+        }else{
+            cache.save(value_type(Integer(workload[i]),Matrix<int>()));
+        }
+    }
+    return hits;
+}
+
+void mrc_tester(){
+    for(int i=0;i<n;i++){
+        int r = next_rand();
+        int s = next_rand();
+        workload[i] = r % 3 ? r % 300 : (r * 32768 + s) % 5000;
+    }
+    int sizes[] = {10,50,100,300,1000,3000};
+
+    //test: with rate 1 the estimate is what the lru does
+    std::cout<<c[2]<<std::endl;
+    {
+        estimator exact(1);
+        sjtu::lru observed(100);
+        observed.set_observer(&exact);
+        run(observed);
+        if(exact.accesses() != n) fail(__LINE__);
+        for(int size : sizes){
+            sjtu::lru cache(size);
+            int hits = run(cache);
+            if(std::fabs(exact.hit_ratio_at(size) * n - hits) > 1e-6) fail(__LINE__);
+            std::cout<<size<<" "<<hits<<std::endl;
+        }
+        if(exact.hit_ratio_at(0) != 0) fail(__LINE__);
+    }
+
+    //test: a tenth of the keys, distances in steps of 10
+    std::cout<<c[3]<<std::endl;
+    {
+        estimator sampled(0.1,10);
+        for(int i=0;i<n;i++)
+            sampled.access(Integer(workload[i]));
+        if(sampled.sampled() > 1000) fail(__LINE__);
+        for(int size : sizes){
+            sjtu::lru cache(size);
+            double actual = (double)run(cache) / n;
+            double estimate = sampled.hit_ratio_at(size);
+            if(std::fabs(actual - estimate) > 0.05) fail(__LINE__);
+        }
+        std::cout<<sampled.sampled()<<std::endl;
+    }
+
+    //test: the smallest cache reaching 60% and 90% hits, within a budget
+    std::cout<<c[4]<<std::endl;
+    {
+        estimator exact(1);
+        for(int i=0;i<n;i++)
+            exact.access(Integer(workload[i]));
+        sjtu::lru cache(10);
+        size_t size = exact.autosize(cache,0.6,10000);
+        if(cache.capacity() != size) fail(__LINE__);
+        if(exact.hit_ratio_at(size) < 0.6 || exact.hit_ratio_at(size - 1) >= 0.6) fail(__LINE__);
+        size_t bigger = exact.suggest_capacity(0.9,10000);
+        size_t capped = exact.suggest_capacity(0.9,1000);
+        std::cout<<size<<" "<<bigger<<" "<<capped<<std::endl;
+    }
+
+    //test: at most 300 keys out of 5000, fed next to a counter
+    std::cout<<c[5]<<std::endl;
+    {
+        struct counter : sjtu::access_observer<Integer> {
+            int gets = 0;
+            void on_access(event e,const Integer &) override {
+                if(e == hit || e == miss) gets++;
+            }
+        } gets;
+        estimator bounded(1,10,300);
+        sjtu::observer_fan<Integer> fan{&gets,&bounded};
+        sjtu::lru observed(100);
+        observed.set_observer(&fan);
+        size_t most = 0;
+        for(int i=0;i<n;i++){
+            if(!observed.get(Integer(workload[i])))
+                observed.save(value_type(Integer(workload[i]),Matrix<int>()));
+            if(bounded.sampled() > most) most = bounded.sampled();
+        }
+        if(gets.gets != n || most > 300) fail(__LINE__);
+        if(bounded.sample_rate() >= 1 || bounded.sample_rate() < 0.03) fail(__LINE__);
+        for(int size : sizes){
+            sjtu::lru cache(size);
+            double actual = (double)run(cache) / n;
+            if(std::fabs(actual - bounded.hit_ratio_at(size)) > 0.05) fail(__LINE__);
+        }
+        fan.remove(&bounded);
+        observed.get(Integer(0));
+        if(gets.gets != n + 1) fail(__LINE__);
+        std::cout<<most<<" "<<(int)(bounded.sample_rate() * 1000)<<std::endl;
+    }
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("21.out","w",stdout);
+#endif
+    mrc_tester();
+    std::cout << c[6] << std::endl;
+}
@@ -0,0 +1,210 @@
+#include "src.hpp"
+#include "spill-tier.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <cstring>
+#include <fstream>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: evicted entries come back from disk",
+    "test2: the cache always has the newest value",
+    "test3: compaction",
+    "test4: compaction in the background",
+    "test5: a budget of bytes",
+    "test6: a damaged segment is compacted",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void fail(int line){
+    std::cout<<c[1]<<" "<<line<<std::endl;
+    exit(0);
+}
+
+unsigned int seed = 7777;
+int next_rand(){
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 16) & 0x7fff;
+}
+
+using value_type = sjtu::pair<Integer,Matrix<int> >;
+using tier = sjtu::spill_tier<Integer,Matrix<int>,Hash,Equal>;
+
+Matrix<int> value_of(int key,int version){
+    Matrix<int> m(key % 4 + 1,3,version);
+    m[0][0] = key;
+    return m;
+}
+
+/**
+ * a tier of at most 16k, then every key kept taken back newest first
+ */
+template<class K,class Tier>
+void bounded(bool background){
+    Tier disk(".",4096,background,16384);
+    unsigned long long most = 0;
+    for(int i=0;i<2000;i++){
+        disk.put(K(i),value_of(i,1));
+        if(disk.disk_bytes() > most) most = disk.disk_bytes();
+    }
+    if(most > 16384) fail(__LINE__);
+    size_t kept = disk.size();
+    // the newest keys are all there, from memory or from disk
+    for(int i=1999;i>=2000-(int)kept;i--){
+        std::unique_ptr<Matrix<int> > res = disk.take(K(i));
+        if(!res || !(*res == value_of(i,1))) fail(__LINE__);
+    }
+    if(disk.size() || disk.take(K(0))) fail(__LINE__);
+    std::cout<<(kept > 100)<<" "<<(disk.segment_count() <= 5)<<std::endl;
+}
+
+void spill_tester(){
+    //test: 500 entries in a cache of 50
+    std::cout<<c[2]<<std::endl;
+    {
+        tier disk(".",1 << 20,false);
+        sjtu::lru tester(50);
+        tester.set_victim_tier(&disk);
+        for(int i=0;i<500;i++)
+            tester.save(value_type(Integer(i),value_of(i,0)));
+        std::cout<<tester.size()<<" "<<disk.size()<<std::endl;
+        for(int i=0;i<500;i++){
+            Matrix<int> *res = tester.get(Integer(i));
+            if(!res || !(*res == value_of(i,0))) fail(__LINE__);
+        }
+        if(tester.get(Integer(500))) fail(__LINE__);
+        Integer keys[] = {Integer(0),Integer(499),Integer(1000)};
+        Matrix<int> *out[3];
+        if(tester.get_many(keys,3,out) != 2) fail(__LINE__);
+        std::cout<<tester.size()<<" "<<disk.size()<<" "<<disk.segment_count()<<std::endl;
+    }
+
+    //test: an overwritten value never comes back from disk
+    std::cout<<c[3]<<std::endl;
+    {
+        tier disk(".",1 << 20,false);
+        sjtu::lru tester(20);
+        tester.set_victim_tier(&disk);
+        int version[100] = {0};
+        for(int i=0;i<20000;i++){
+            int key = next_rand() % 100;
+            if(next_rand() % 2){
+                version[key]++;
+                tester.save(value_type(Integer(key),value_of(key,version[key])));
+            }else{
+                Matrix<int> *res = tester.get(Integer(key));
+                if(version[key] && (!res || !(*res == value_of(key,version[key])))) fail(__LINE__);
+                if(!version[key] && res) fail(__LINE__);
+            }
+        }
+        std::cout<<tester.size() + disk.size()<<std::endl;
+    }
+
+    //test: garbage is dropped, live records survive
+    std::cout<<c[4]<<std::endl;
+    {
+        tier disk(".",4096,false);
+        for(int i=0;i<400;i++)
+            disk.put(Integer(i),value_of(i,1));
+        for(int i=0;i<400;i++)
+            if(i % 4)
+                disk.erase(Integer(i));
+        unsigned long long before = disk.disk_bytes();
+        size_t segments = disk.segment_count();
+        size_t compacted = disk.compact();
+        if(disk.disk_bytes() >= before || disk.segment_count() >= segments) fail(__LINE__);
+        for(int i=0;i<400;i++){
+            std::unique_ptr<Matrix<int> > res = disk.take(Integer(i));
+            if((i % 4 == 0) != (res != nullptr)) fail(__LINE__);
+            if(res && !(*res == value_of(i,1))) fail(__LINE__);
+        }
+        std::cout<<compacted<<" "<<disk.size()<<" "<<disk.compact()<<std::endl;
+    }
+
+    //test: the compactor thread works while the cache is used
+    //(int keys: Integer counts its instances without a lock)
+    std::cout<<c[5]<<std::endl;
+    {
+        using cache = sjtu::basic_lru<int,Matrix<int> >;
+        sjtu::spill_tier<int,Matrix<int> > disk(".",8192);
+        cache tester(30);
+        tester.set_victim_tier(&disk);
+        int version[300] = {0};
+        for(int i=0;i<30000;i++){
+            int key = next_rand() % 300;
+            if(next_rand() % 3 == 0){
+                version[key]++;
+                tester.save(cache::value_type(key,value_of(key,version[key])));
+            }else{
+                Matrix<int> *res = tester.get(key);
+                if(version[key] && (!res || !(*res == value_of(key,version[key])))) fail(__LINE__);
+            }
+        }
+        for(int key=0;key<300;key++){
+            Matrix<int> *res = tester.get(key);
+            if(version[key] && (!res || !(*res == value_of(key,version[key])))) fail(__LINE__);
+        }
+        std::cout<<tester.size() + disk.size()<<std::endl;
+    }
+
+    //test: 16k of segments of 4k, the oldest keys go first
+    std::cout<<c[6]<<std::endl;
+    {
+        bounded<Integer,tier>(false);
+        bounded<int,sjtu::spill_tier<int,Matrix<int> > >(true);
+    }
+
+    //test: the key length of the 4th record of segment 0 is garbage
+    std::cout<<c[7]<<std::endl;
+    {
+        tier disk(".",4096,false);
+        for(int i=0;i<100;i++)
+            disk.put(Integer(i),value_of(i,1));
+        std::string data;
+        {
+            std::ifstream in("./segment-0.log",std::ios::binary);
+            data.assign(std::istreambuf_iterator<char>(in),std::istreambuf_iterator<char>());
+        }
+        size_t offset = 0;
+        int records = 0;
+        while(offset < data.size()){
+            unsigned key_len, value_len;
+            std::memcpy(&key_len,&data[offset],4);
+            std::memcpy(&value_len,&data[offset + 4],4);
+            if(records == 3){
+                unsigned garbage = 3;
+                std::fstream out("./segment-0.log",std::ios::binary | std::ios::in | std::ios::out);
+                out.seekp(offset);
+                out.write((const char *)&garbage,4);
+            }
+            offset += 8 + key_len + value_len + 8;
+            records++;
+        }
+        // every other key of segment 0 is garbage now, so it is compacted
+        for(int i=1;i<records;i+=2)
+            disk.erase(Integer(i));
+        if(disk.compact() != 1) fail(__LINE__);
+        int kept = 0;
+        for(int i=0;i<records;i+=2)
+            kept += disk.take(Integer(i)) != nullptr;
+        // the later segments are untouched
+        for(int i=records;i<100;i++){
+            std::unique_ptr<Matrix<int> > res = disk.take(Integer(i));
+            if(!res || !(*res == value_of(i,1))) fail(__LINE__);
+        }
+        std::cout<<kept<<" "<<disk.size()<<" "<<disk.good()<<std::endl;
+    }
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("22.out","w",stdout);
+#endif
+    spill_tester();
+    std::cout << c[8] << std::endl;
+}
@@ -0,0 +1,194 @@
+#include "src.hpp"
+#include "export.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: old entries are compressed",
+    "test2: the same hits and order as plain values",
+    "test3: more entries under the same weight",
+    "test4: visitors and snapshots see plain values",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void fail(int line){
+    std::cout<<c[1]<<" "<<line<<std::endl;
+    exit(0);
+}
+
+unsigned int seed = 31415;
+int next_rand(){
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 16) & 0x7fff;
+}
+
+using value_type = sjtu::pair<Integer,Matrix<int> >;
+
+/**
+ * smooth values, as the ones worth compressing
+ */
+Matrix<int> value_of(int key){
+    Matrix<int> m(16,16);
+    for(int i=0;i<16;i++)
+        for(int j=0;j<16;j++)
+            m[i][j] = key * 1000 + i * 16 + j - (key % 7 == 0 ? 100000 : 0);
+    return m;
+}
+
+std::string text(sjtu::lru &cache){
+    std::ostringstream out;
+    sjtu::dump<sjtu::text_format>(cache,out);
+    return out.str();
+}
+
+void cold_tester(){
+    //test: three quarters of the entries are cold, hits unpack them
+    std::cout<<c[2]<<std::endl;
+    {
+        sjtu::lru tester(400);
+        tester.set_hot_fraction(0.25);
+        for(int i=0;i<400;i++)
+            tester.save(value_type(Integer(i),value_of(i)));
+        std::cout<<tester.size()<<" "<<tester.cold_size()<<" "<<tester.weight()<<std::endl;
+        for(int i=0;i<400;i++){
+            Matrix<int> *res = tester.get(Integer(i));
+            if(!res || !(*res == value_of(i))) fail(__LINE__);
+            if(tester.cold_size() != 300) fail(__LINE__);
+        }
+        tester.set_hot_fraction(1);
+        if(tester.cold_size() != 0 || tester.weight() != 400 * 16 * 16 * sizeof(int)) fail(__LINE__);
+    }
+
+    //test: a random mix against a cache without cold zone
+    std::cout<<c[3]<<std::endl;
+    {
+        sjtu::lru plain(100), zoned(100);
+        zoned.set_hot_fraction(0.3);
+        int hits = 0;
+        for(int i=0;i<20000;i++){
+            int key = next_rand() % 180;
+            int op = next_rand() % 3;
+            if(op == 0){
+                Matrix<int> m = value_of(key + i);
+                plain.save(value_type(Integer(key),m));
+                zoned.save(value_type(Integer(key),m));
+            }else{
+                Matrix<int> *a = plain.get(Integer(key));
+                Matrix<int> *b = zoned.get(Integer(key));
+                if(!a != !b || (a && !(*a == *b))) fail(__LINE__);
+                hits += a != nullptr;
+            }
+            if(i == 10000){
+                plain.set_capacity(60);
+                zoned.set_capacity(60);
+            }
+        }
+        if(text(plain) != text(zoned)) fail(__LINE__);
+        std::cout<<hits<<" "<<zoned.size()<<" "<<zoned.cold_size()<<std::endl;
+    }
+
+    //test: a weight bound of 100 plain matrices
+    std::cout<<c[4]<<std::endl;
+    {
+        size_t budget = 100 * 16 * 16 * sizeof(int);
+        sjtu::lru plain(10000,budget), zoned(10000,budget);
+        zoned.set_hot_fraction(0.01);
+        for(int i=0;i<5000;i++){
+            plain.save(value_type(Integer(i),value_of(i)));
+            zoned.save(value_type(Integer(i),value_of(i)));
+        }
+        if(zoned.weight() > budget) fail(__LINE__);
+        for(int i=5000-(int)zoned.size();i<5000;i++){
+            Matrix<int> *res = zoned.get(Integer(i));
+            if(!res || !(*res == value_of(i))) fail(__LINE__);
+        }
+        std::cout<<plain.size()<<" "<<zoned.size()<<std::endl;
+
+        // 200 plain matrices of weight, but more than 200 cold ones;
+        // with a bigger hot zone every hit unpacks one and makes room,
+        // the bound holds
+        size_t half = 200 * 16 * 16 * sizeof(int);
+        sjtu::lru dense(400,half);
+        dense.set_hot_fraction(0.25);
+        for(int i=0;i<400;i++)
+            dense.save(value_type(Integer(i),value_of(i)));
+        size_t kept = dense.size();
+        dense.set_hot_fraction(0.9);
+        int found = 0;
+        for(int i=0;i<400;i++){
+            Matrix<int> *res = dense.get(Integer(i));
+            if(res && !(*res == value_of(i))) fail(__LINE__);
+            found += res != nullptr;
+            if(dense.weight() > half) fail(__LINE__);
+        }
+        dense.set_hot_fraction(1);
+        if(dense.weight() > half || dense.size() > 200) fail(__LINE__);
+        std::cout<<kept<<" "<<found<<" "<<dense.size()<<std::endl;
+
+        // a cold entry too heavy once unpacked is evicted to the tier
+        struct memory_tier : sjtu::victim_tier<Integer,Matrix<int> > {
+            sjtu::linked_hashmap<Integer,Matrix<int>,Hash,Equal> kept;
+            void put(const Integer &key,const Matrix<int> &value) override { kept.insert({key,value}); }
+            std::unique_ptr<Matrix<int> > take(const Integer &key) override {
+                auto iter = kept.find(key);
+                if(iter == kept.end()) return nullptr;
+                std::unique_ptr<Matrix<int> > value(new Matrix<int>(iter->second));
+                kept.remove(iter);
+                return value;
+            }
+            void erase(const Integer &key) override {
+                auto iter = kept.find(key);
+                if(iter != kept.end()) kept.remove(iter);
+            }
+        } spill;
+        sjtu::lru small(4);
+        small.set_victim_tier(&spill);
+        small.set_hot_fraction(0.25);
+        for(int i=0;i<3;i++)
+            small.save(value_type(Integer(i),value_of(i)));
+        small.save(value_type(Integer(3),Matrix<int>(1,1,3)));
+        small.set_max_weight(16 * 16 * sizeof(int) - 1);
+        unsigned long long evicted = small.stats().evictions;
+        if(small.get(Integer(1))) fail(__LINE__);
+        if(small.stats().evictions != evicted + 1 || small.size() != 3) fail(__LINE__);
+        auto spilled = spill.kept.find(Integer(1));
+        if(spilled == spill.kept.end() || !(spilled->second == value_of(1))) fail(__LINE__);
+        std::cout<<small.size()<<" "<<spill.kept.size()<<std::endl;
+    }
+
+    //test: print, dumps and snapshots of a half cold cache
+    std::cout<<c[5]<<std::endl;
+    {
+        sjtu::lru tester(4);
+        tester.set_hot_fraction(0.5);
+        for(int i=0;i<6;i++)
+            tester.save(value_type(Integer(i),Matrix<int>(1,3,i - 3)));
+        std::cout<<tester.cold_size()<<std::endl;
+        tester.print();
+        sjtu::lru big(400);
+        big.set_hot_fraction(0.1);
+        for(int i=0;i<400;i++)
+            big.save(value_type(Integer(i),value_of(i)));
+        big.save_snapshot("23.snapshot");
+        sjtu::lru copy(400);
+        copy.load_snapshot("23.snapshot");
+        std::remove("23.snapshot");
+        if(text(big) != text(copy) || copy.cold_size() != 0) fail(__LINE__);
+    }
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("23.out","w",stdout);
+#endif
+    cold_tester();
+    std::cout << c[6] << std::endl;
+}
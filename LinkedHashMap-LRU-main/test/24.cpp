@@ -0,0 +1,139 @@
+#include "src.hpp"
+#include "async-lru.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: hits, misses, inserts, updates and evictions",
+    "test2: batches and loads",
+    "test3: loads of an async cache",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void fail(int line){
+    std::cout<<c[1]<<" "<<line<<std::endl;
+    exit(0);
+}
+
+unsigned int seed = 4242;
+int next_rand(){
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 16) & 0x7fff;
+}
+
+using value_type = sjtu::pair<Integer,Matrix<int> >;
+
+void print(const sjtu::cache_stats &s){
+    std::cout<<s.hits<<" "<<s.misses<<" "<<s.inserts<<" "<<s.updates<<" "<<s.evictions
+             <<" "<<s.load_successes<<" "<<s.load_failures<<" "<<s.size<<" "<<s.weight<<std::endl;
+}
+
+void stats_tester(){
+    //test: every event counted once, against a model lru kept by hand
+    std::cout<<c[2]<<std::endl;
+    {
+        const int capacity = 50, keys = 200;
+        sjtu::lru tester(capacity);
+        // last use of every key, 0 if not cached
+        int used[keys] = {0};
+        int cached = 0;
+        unsigned long long hits = 0, misses = 0, inserts = 0, updates = 0, evictions = 0;
+        for(int i=1;i<=20000;i++){
+            int key = next_rand() % keys;
+            int op = next_rand() % 2;
+            if(op){
+                tester.save(value_type(Integer(key),Matrix<int>(1,1,key)));
+                if(used[key]){
+                    updates++;
+                }else{
+                    inserts++;
+                    cached++;
+                }
+                used[key] = i;
+                if(cached > capacity){
+                    int oldest = -1;
+                    for(int k=0;k<keys;k++)
+                        if(used[k] && (oldest < 0 || used[k] < used[oldest])) oldest = k;
+                    used[oldest] = 0;
+                    cached--;
+                    evictions++;
+                }
+            }else if(tester.get(Integer(key))){
+                if(!used[key]) fail(__LINE__);
+                used[key] = i;
+                hits++;
+            }else{
+                if(used[key]) fail(__LINE__);
+                misses++;
+            }
+        }
+        sjtu::cache_stats s = tester.stats();
+        if(s.hits != hits || s.misses != misses) fail(__LINE__);
+        if(s.inserts != inserts || s.updates != updates || s.evictions != evictions) fail(__LINE__);
+        if(s.size != tester.size() || s.weight != tester.weight()) fail(__LINE__);
+        print(s);
+        tester.reset_stats();
+        s = tester.stats();
+        if(s.hits || s.misses || s.inserts || s.updates || s.evictions || s.size != capacity) fail(__LINE__);
+        std::cout<<s.hit_ratio()<<std::endl;
+    }
+
+    //test: get_many counts every key, get_or_load its loader calls
+    std::cout<<c[3]<<std::endl;
+    {
+        sjtu::lru tester(10);
+        for(int i=0;i<10;i++)
+            tester.save(value_type(Integer(i),Matrix<int>(1,1,i)));
+        Integer batch[] = {Integer(1),Integer(20),Integer(3),Integer(30)};
+        Matrix<int> *out[4];
+        if(tester.get_many(batch,4,out) != 2) fail(__LINE__);
+        auto load = [](const Integer &key){
+            if(key.val % 2) throw std::runtime_error("odd");
+            return Matrix<int>(1,1,key.val);
+        };
+        for(int i=5;i<15;i++){
+            try{
+                tester.get_or_load(Integer(i),load);
+            }catch(const std::runtime_error &){
+            }
+        }
+        sjtu::cache_stats s = tester.stats();
+        print(s);
+        if(s.load_successes != 3 || s.load_failures != 2) fail(__LINE__);
+        std::cout<<s.hit_ratio()<<std::endl;
+    }
+
+    //test: loads run by the executor are counted as well
+    std::cout<<c[4]<<std::endl;
+    {
+        sjtu::thread_pool pool(2);
+        sjtu::async_lru<int,Matrix<int> > tester(100,pool);
+        auto load = [](int key){
+            if(key % 3 == 0) throw std::runtime_error("three");
+            return Matrix<int>(1,1,key);
+        };
+        for(int i=0;i<30;i++)
+            tester.get(i,load);
+        tester.wait();
+        sjtu::cache_stats s = tester.stats();
+        print(s);
+        if(s.load_successes != 20 || s.load_failures != 10 || s.misses != 30) fail(__LINE__);
+        tester.reset_stats();
+        if(tester.stats().misses) fail(__LINE__);
+    }
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("24.out","w",stdout);
+#endif
+    stats_tester();
+    std::cout << c[5] << std::endl;
+}
@@ -0,0 +1,97 @@
+#define SJTU_LATENCY
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: buckets and percentiles",
+    "test2: every save, get, expand and remove is timed",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void fail(int line){
+    std::cout<<c[1]<<" "<<line<<std::endl;
+    exit(0);
+}
+
+unsigned int seed = 2718;
+int next_rand(){
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 16) & 0x7fff;
+}
+
+using value_type = sjtu::pair<Integer,Matrix<int> >;
+using histogram = sjtu::latency_histogram;
+
+void latency_tester(){
+    //test: known values, each bucket within 1/8 of what it holds
+    std::cout<<c[2]<<std::endl;
+    {
+        for(unsigned long long v=0;v<(1ull<<20);v=v*9/8+1){
+            size_t b = histogram::bucket_of(v);
+            if(histogram::bucket_high(b) < v) fail(__LINE__);
+            if(v >= 8 && histogram::bucket_high(b) - v > v / 8) fail(__LINE__);
+            if(b && histogram::bucket_high(b - 1) >= v) fail(__LINE__);
+        }
+        if(histogram::bucket_of(~0ull) >= histogram::BUCKETS) fail(__LINE__);
+        histogram h;
+        if(h.percentile(0.99) != 0) fail(__LINE__);
+        for(int i=1;i<=1000;i++)
+            h.record(i);
+        h.record(1000000);
+        std::cout<<h.count()<<" "<<h.percentile(0.5)<<" "<<h.percentile(0.99)<<" "
+                 <<h.percentile(0.999)<<" "<<h.percentile(1)<<" "<<h.max()<<std::endl;
+        if(h.percentile(0.5) < 500 || h.percentile(0.5) > 500 + 500 / 8) fail(__LINE__);
+        h.reset();
+        if(h.count() || h.max() || h.mean() != 0) fail(__LINE__);
+    }
+
+    //test: the counts of the histograms follow the operations
+    std::cout<<c[3]<<std::endl;
+    {
+        sjtu::lru tester(100);
+        unsigned long long saves = 0, gets = 0;
+        for(int i=0;i<5000;i++){
+            int key = next_rand() % 300;
+            if(next_rand() % 2){
+                tester.save(value_type(Integer(key),Matrix<int>(2,2,key)));
+                saves++;
+            }else{
+                tester.get(Integer(key));
+                gets++;
+            }
+        }
+        if(tester.save_latency().count() != saves) fail(__LINE__);
+        if(tester.get_latency().count() != gets) fail(__LINE__);
+        sjtu::cache_stats s = tester.stats();
+        if(tester.remove_latency().count() != s.evictions) fail(__LINE__);
+        if(tester.save_latency().percentile(0.99) > tester.save_latency().max()) fail(__LINE__);
+        tester.set_capacity(1000);
+        for(int i=0;i<1000;i++)
+            tester.save(value_type(Integer(i),Matrix<int>()));
+        std::cout<<tester.expand_latency().count()<<std::endl;
+        tester.reset_latency();
+        if(tester.save_latency().count() || tester.expand_latency().count()) fail(__LINE__);
+
+        sjtu::linked_hashmap<Integer,int,Hash,Equal> map;
+        for(int i=0;i<1000;i++)
+            map.insert({Integer(i),i});
+        for(int i=0;i<1000;i+=2)
+            map.remove(map.find(Integer(i)));
+        std::cout<<map.expand_latency.count()<<" "<<map.remove_latency.count()<<std::endl;
+    }
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("25.out","w",stdout);
+#endif
+    latency_tester();
+    std::cout << c[4] << std::endl;
+}
@@ -0,0 +1,99 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: an empty table and a hand-made one",
+    "test2: strided keys cluster under the identity hash",
+    "test3: the table under an lru",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void fail(int line){
+    std::cout<<c[1]<<" "<<line<<std::endl;
+    exit(0);
+}
+
+/**
+ * the murmur3 finalizer, a hash that mixes every bit
+ */
+class MixHash {
+public:
+    unsigned int operator()(Integer lhs) const {
+        unsigned int h = lhs.val;
+        h ^= h >> 16;
+        h *= 0x85ebca6bu;
+        h ^= h >> 13;
+        h *= 0xc2b2ae35u;
+        return h ^ (h >> 16);
+    }
+};
+
+void diagnostics_tester(){
+    //test: chains counted by hand
+    std::cout<<c[2]<<std::endl;
+    {
+        sjtu::hashmap<Integer,int,Hash,Equal> map(4);
+        sjtu::table_diagnostics d = map.diagnostics();
+        if(d.size || d.max_chain || d.probes_hit != 0 || d.chains.size() != 1 || d.chains[0] != 4) fail(__LINE__);
+        // buckets: {0, 4, 8}, {1}, {}, {}
+        map.insert({Integer(0),0});
+        map.insert({Integer(4),4});
+        map.insert({Integer(8),8});
+        map.insert({Integer(1),1});
+        d = map.diagnostics();
+        if(d.capacity != 4 || d.probes_hit != 1.75) fail(__LINE__);
+        d.print(std::cout);
+        if(d.max_chain != 3 || d.chains[3] != 1 || d.chains[1] != 1 || d.chains[0] != 2) fail(__LINE__);
+        if(d.bucket_bytes != 4 * sizeof(sjtu::hashmap<Integer,int,Hash,Equal>::list)) fail(__LINE__);
+    }
+
+    //test: keys 0, 64, 128, ... fill one bucket in 64 with Hash, none with MixHash
+    std::cout<<c[3]<<std::endl;
+    {
+        sjtu::linked_hashmap<Integer,int,Hash,Equal> identity;
+        sjtu::linked_hashmap<Integer,int,MixHash,Equal> mixed;
+        for(int i=0;i<4000;i++){
+            identity.insert({Integer(i * 64),i});
+            mixed.insert({Integer(i * 64),i});
+        }
+        sjtu::table_diagnostics a = identity.diagnostics();
+        sjtu::table_diagnostics b = mixed.diagnostics();
+        std::cout<<a.capacity<<" "<<a.max_chain<<" "<<a.mean_chain<<" "<<a.probes_hit<<std::endl;
+        std::cout<<b.capacity<<" "<<b.max_chain<<" "<<b.mean_chain<<" "<<b.probes_hit<<std::endl;
+        if(a.capacity != b.capacity || a.probes_miss != b.probes_miss) fail(__LINE__);
+        if(a.max_chain < 4 * b.max_chain || a.probes_hit < 4 * b.probes_hit) fail(__LINE__);
+        size_t total = 0, used = 0;
+        for(size_t k=0;k<b.chains.size();k++){
+            total += k * b.chains[k];
+            used += b.chains[k];
+        }
+        if(total != 4000 || used != b.capacity) fail(__LINE__);
+        if(a.node_bytes != 2 * 4000 * (sizeof(sjtu::linked_hashmap<Integer,int,Hash,Equal>::Node) + sizeof(sjtu::pair<const Integer,int>))) fail(__LINE__);
+    }
+
+    //test: an lru reserves its table at once
+    std::cout<<c[4]<<std::endl;
+    {
+        sjtu::lru tester(300);
+        for(int i=0;i<1000;i++)
+            tester.save(sjtu::pair<Integer,Matrix<int> >(Integer(i),Matrix<int>()));
+        sjtu::table_diagnostics d = tester.diagnostics();
+        std::cout<<d.size<<" "<<d.capacity<<" "<<d.max_chain<<std::endl;
+        if(d.size != 300 || d.load_factor() > 0.75) fail(__LINE__);
+    }
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("26.out","w",stdout);
+#endif
+    diagnostics_tester();
+    std::cout << c[5] << std::endl;
+}
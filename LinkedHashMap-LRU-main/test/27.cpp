@@ -0,0 +1,98 @@
+#define SJTU_ALLOC_STATS
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: live bytes by category",
+    "test2: what expand costs",
+    "test3: an lru in steady state",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void fail(int line){
+    std::cout<<c[1]<<" "<<line<<std::endl;
+    exit(0);
+}
+
+using account = sjtu::alloc_account;
+using map_type = sjtu::linked_hashmap<Integer,int,Hash,Equal>;
+const size_t node_bytes = sizeof(map_type::Node);
+const size_t value_bytes = sizeof(map_type::value_type);
+const size_t list_bytes = sizeof(map_type::list);
+
+void print(const account &a){
+    const char *names[] = {"buckets","order","chain","values"};
+    for(int i=0;i<account::CATEGORIES;i++){
+        account::counts n = a.get(account::category(i));
+        std::cout<<names[i]<<" "<<n.allocations<<" "<<n.frees<<std::endl;
+    }
+}
+
+void alloc_tester(){
+    //test: after inserts and removes, the live bytes are those of what is left
+    std::cout<<c[2]<<std::endl;
+    {
+        map_type map;
+        for(int i=0;i<1000;i++)
+            map.insert({Integer(i),i});
+        for(int i=0;i<1000;i+=4)
+            map.remove(map.find(Integer(i)));
+        const account &a = map.allocations;
+        if(a.get(account::buckets).live_bytes != map.capacity * list_bytes) fail(__LINE__);
+        if(a.get(account::order_nodes).live_bytes != 750 * node_bytes) fail(__LINE__);
+        if(a.get(account::chain_nodes).live_bytes != 750 * node_bytes) fail(__LINE__);
+        if(a.get(account::values).live_bytes != 2 * 750 * value_bytes) fail(__LINE__);
+        if(a.get(account::order_nodes).allocations != 1000 || a.get(account::order_nodes).frees != 250) fail(__LINE__);
+        map.clear();
+        if(a.total().live_bytes != map.capacity * list_bytes) fail(__LINE__);
+        print(a);
+    }
+
+    //test: a rehash copies every node twice, a reserved table never does
+    std::cout<<c[3]<<std::endl;
+    {
+        map_type grown, reserved;
+        reserved.reserve(1000);
+        for(int i=0;i<1000;i++){
+            grown.insert({Integer(i),i});
+            reserved.insert({Integer(i),i});
+        }
+        account::counts g = grown.allocations.get(account::chain_nodes);
+        account::counts r = reserved.allocations.get(account::chain_nodes);
+        std::cout<<g.allocations<<" "<<g.frees<<" "<<r.allocations<<" "<<r.frees<<std::endl;
+        if(r.allocations != 1000 || r.frees || g.allocations - g.frees != 1000) fail(__LINE__);
+        size_t before = grown.allocations.total().allocations;
+        grown.expand();
+        std::cout<<grown.allocations.total().allocations - before<<std::endl;
+    }
+
+    //test: every save of a new key evicts, the allocations of a save are all freed
+    std::cout<<c[4]<<std::endl;
+    {
+        sjtu::lru tester(100);
+        for(int i=0;i<100;i++)
+            tester.save(sjtu::pair<Integer,Matrix<int> >(Integer(i),Matrix<int>()));
+        unsigned long long live = tester.allocations().total().live_bytes;
+        tester.reset_allocations();
+        for(int i=100;i<1100;i++)
+            tester.save(sjtu::pair<Integer,Matrix<int> >(Integer(i),Matrix<int>()));
+        account::counts t = tester.allocations().total();
+        std::cout<<t.allocations<<" "<<t.frees<<std::endl;
+        if(t.live_bytes != live || t.allocations != t.frees) fail(__LINE__);
+    }
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("27.out","w",stdout);
+#endif
+    alloc_tester();
+    std::cout << c[5] << std::endl;
+}
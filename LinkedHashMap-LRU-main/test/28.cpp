@@ -0,0 +1,182 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <memory_resource>
+#include <new>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: a stateful allocator of our own",
+    "test2: an lru in a monotonic arena",
+    "test3: a pool resource under churn",
+    "test4: a failed allocation leaks nothing",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void fail(int line){
+    std::cout<<c[1]<<" "<<line<<std::endl;
+    exit(0);
+}
+
+unsigned int seed = 1618;
+int next_rand(){
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 16) & 0x7fff;
+}
+
+/**
+ * counts what is allocated through it in a shared counter,
+ * and throws at allocation number fail_at
+ */
+struct counter {
+    long allocations = 0;
+    long live = 0;
+    long fail_at = -1;
+};
+template <class T>
+struct counting_allocator {
+    using value_type = T;
+    counter *owner;
+    explicit counting_allocator(counter *owner) : owner(owner) {}
+    template <class U>
+    counting_allocator(const counting_allocator<U> &other) : owner(other.owner) {}
+    T *allocate(size_t n){
+        if(owner->allocations++ == owner->fail_at)
+            throw std::bad_alloc();
+        owner->live++;
+        return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+    void deallocate(T *p, size_t){
+        owner->live--;
+        ::operator delete(p);
+    }
+    template <class U>
+    bool operator==(const counting_allocator<U> &other) const { return owner == other.owner; }
+    template <class U>
+    bool operator!=(const counting_allocator<U> &other) const { return owner != other.owner; }
+};
+
+/**
+ * a resource counting the bytes it hands out
+ */
+class counting_resource : public std::pmr::memory_resource {
+    std::pmr::memory_resource *upstream;
+public:
+    size_t bytes = 0;
+    explicit counting_resource(std::pmr::memory_resource *upstream) : upstream(upstream) {}
+private:
+    void *do_allocate(size_t n, size_t align) override {
+        bytes += n;
+        return upstream->allocate(n, align);
+    }
+    void do_deallocate(void *p, size_t n, size_t align) override {
+        upstream->deallocate(p, n, align);
+    }
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+};
+
+using value_type = sjtu::pair<Integer,Matrix<int> >;
+
+void allocator_tester(){
+    //test: every node, value and bucket array comes from the allocator
+    std::cout<<c[2]<<std::endl;
+    {
+        counter count;
+        {
+            using map_type = sjtu::linked_hashmap<Integer,int,Hash,Equal,counting_allocator<sjtu::pair<const Integer,int> > >;
+            map_type map{counting_allocator<sjtu::pair<const Integer,int> >(&count)};
+            for(int i=0;i<1000;i++)
+                map.insert({Integer(i),i});
+            for(int i=0;i<1000;i+=2)
+                map.remove(map.find(Integer(i)));
+            // 500 entries: a history node, a bucket node, a value each; one bucket array
+            if(count.live != 4 * 500 + 1) fail(__LINE__);
+            map_type copy(map);
+            if(copy.size() != 500 || copy.at(Integer(999)) != 999) fail(__LINE__);
+            if(count.live != 2 * (4 * 500 + 1)) fail(__LINE__);
+            using cache = sjtu::basic_lru<Integer,Matrix<int>,Hash,Equal,counting_allocator<value_type> >;
+            cache tester(100,counting_allocator<value_type>(&count));
+            for(int i=0;i<1000;i++)
+                tester.save(value_type(Integer(i),Matrix<int>(1,1,i)));
+            if(count.live != 2 * (4 * 500 + 1) + 4 * 100 + 1) fail(__LINE__);
+            std::cout<<count.allocations<<std::endl;
+        }
+        if(count.live) fail(__LINE__);
+    }
+
+    //test: nothing of the table is left to the default heap
+    std::cout<<c[3]<<std::endl;
+    {
+        static char buffer[1 << 20];
+        std::pmr::monotonic_buffer_resource arena(buffer,sizeof(buffer),std::pmr::null_memory_resource());
+        counting_resource counted(&arena);
+        sjtu::pmr::lru tester(200,&counted);
+        for(int i=0;i<1000;i++)
+            tester.save(value_type(Integer(i),Matrix<int>(2,2,i)));
+        for(int i=800;i<1000;i++){
+            Matrix<int> *res = tester.get(Integer(i));
+            if(!res || !(*res == Matrix<int>(2,2,i))) fail(__LINE__);
+        }
+        if(tester.get(Integer(799))) fail(__LINE__);
+        std::cout<<tester.size()<<" "<<(counted.bytes > 0)<<std::endl;
+    }
+
+    //test: a pool recycles what eviction frees
+    std::cout<<c[4]<<std::endl;
+    {
+        std::pmr::unsynchronized_pool_resource pool;
+        counting_resource counted(&pool);
+        sjtu::pmr::linked_hashmap<int,int> map(&counted);
+        sjtu::pmr::basic_lru<int,int> tester(50,&counted);
+        int hits = 0;
+        for(int i=0;i<20000;i++){
+            int key = next_rand() % 200;
+            if(tester.get(key)){
+                hits++;
+            }else{
+                tester.save(sjtu::pmr::basic_lru<int,int>::value_type(key,key));
+                map.insert({key,i});
+            }
+        }
+        std::cout<<hits<<" "<<map.size()<<std::endl;
+    }
+
+    //test: the value, then the node allocation of an insert fails
+    std::cout<<c[5]<<std::endl;
+    {
+        counter count;
+        int before = Integer::counter;
+        int failures = 0;
+        {
+            using alloc = counting_allocator<sjtu::pair<const Integer,int> >;
+            sjtu::hashmap<Integer,int,Hash,Equal,alloc> map(256,alloc(&count));
+            for(int i=0;i<100;i++){
+                count.fail_at = count.allocations + i % 3;
+                try{
+                    map.insert({Integer(i),i});
+                }catch(const std::bad_alloc &){
+                    failures++;
+                }
+            }
+            count.fail_at = -1;
+            if(map.size + failures != 100) fail(__LINE__);
+        }
+        if(count.live || Integer::counter != before) fail(__LINE__);
+        std::cout<<failures<<std::endl;
+    }
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("28.out","w",stdout);
+#endif
+    allocator_tester();
+    std::cout << c[6] << std::endl;
+}
@@ -0,0 +1,145 @@
+#include "src.hpp"
+#include "slab-allocator.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: blocks are recycled",
+    "test2: no operator new in steady state",
+    "test3: the same results as the default heap",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+// every operator new of the program is counted
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+size_t news = 0;
+void *operator new(size_t n){
+    news++;
+    void *p = std::malloc(n ? n : 1);
+    if(!p) throw std::bad_alloc();
+    return p;
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+void fail(int line){
+    std::cout<<c[1]<<" "<<line<<std::endl;
+    exit(0);
+}
+
+unsigned int seed = 1414;
+int next_rand(){
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 16) & 0x7fff;
+}
+
+template <class Cache>
+std::string text(Cache &cache){
+    std::ostringstream out;
+    cache.for_each([&out](const Integer &key, const Matrix<int> &value){
+        out<<key.val<<" "<<value.RowSize()<<" "<<value[0][0]<<"\n";
+    });
+    return out.str();
+}
+
+void slab_tester(){
+    //test: a freed block is the next one of its size handed out
+    std::cout<<c[2]<<std::endl;
+    {
+        sjtu::slab_pool pool(4096);
+        void *a = pool.allocate(24,8);
+        void *b = pool.allocate(24,8);
+        void *d = pool.allocate(100,8);
+        if(a == b || (size_t)a % sjtu::slab_pool::GRAIN) fail(__LINE__);
+        pool.deallocate(a,24,8);
+        pool.deallocate(d,100,8);
+        if(pool.allocate(17,8) != a || pool.allocate(100,8) != d) fail(__LINE__);
+        if(pool.free_blocks()) fail(__LINE__);
+        void *big = pool.allocate(10000,8);
+        pool.deallocate(big,10000,8);
+        for(int i=0;i<1000;i++)
+            pool.allocate(32,8);
+        std::cout<<pool.chunks_allocated()<<std::endl;
+    }
+
+    //test: once full, evicting and inserting only reuse blocks
+    std::cout<<c[3]<<std::endl;
+    {
+        sjtu::slab_pool pool;
+        sjtu::slab_lru<int,int> tester(1000,&pool);
+        sjtu::basic_lru<int,int> plain(1000);
+        for(int i=0;i<2000;i++){
+            tester.save(sjtu::slab_lru<int,int>::value_type(i,i));
+            plain.save(sjtu::basic_lru<int,int>::value_type(i,i));
+        }
+        size_t before = news;
+        size_t chunks = pool.chunks_allocated();
+        for(int i=0;i<100000;i++){
+            int key = 2000 + i;
+            tester.save(sjtu::slab_lru<int,int>::value_type(key,key));
+            int *res = tester.get(key - 1);
+            if(!res || *res != key - 1) fail(__LINE__);
+        }
+        size_t slab_news = news - before;
+        before = news;
+        for(int i=0;i<100000;i++)
+            plain.save(sjtu::basic_lru<int,int>::value_type(2000 + i,i));
+        size_t plain_news = news - before;
+        if(pool.chunks_allocated() != chunks) fail(__LINE__);
+        std::cout<<slab_news<<" "<<plain_news<<std::endl;
+        if(slab_news) fail(__LINE__);
+    }
+
+    //test: a random mix, with the table grown and copied
+    std::cout<<c[4]<<std::endl;
+    {
+        using value_type = sjtu::pair<Integer,Matrix<int> >;
+        using cache = sjtu::slab_lru<Integer,Matrix<int>,Hash,Equal>;
+        sjtu::slab_pool pool;
+        cache tester(100,&pool);
+        sjtu::lru plain(100);
+        for(int i=0;i<30000;i++){
+            int key = next_rand() % 300;
+            if(next_rand() % 3 == 0){
+                Matrix<int> m(key % 3 + 1,2,i);
+                tester.save(value_type(Integer(key),m));
+                plain.save(value_type(Integer(key),m));
+            }else if(!tester.get(Integer(key)) != !plain.get(Integer(key))){
+                fail(__LINE__);
+            }
+            if(i == 15000){
+                tester.set_capacity(250);
+                plain.set_capacity(250);
+            }
+        }
+        if(text(tester) != text(plain)) fail(__LINE__);
+        using map_type = sjtu::linked_hashmap<int,int,std::hash<int>,std::equal_to<int>,sjtu::slab_allocator<sjtu::pair<const int,int> > >;
+        map_type map(&pool);
+        for(int i=0;i<5000;i++)
+            map.insert({i,i * 2});
+        map_type copy(map);
+        for(int i=0;i<5000;i+=2)
+            copy.remove(copy.find(i));
+        if(map.size() != 5000 || copy.size() != 2500 || copy.at(4999) != 9998) fail(__LINE__);
+        std::cout<<tester.size()<<" "<<copy.size()<<std::endl;
+    }
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("29.out","w",stdout);
+#endif
+    slab_tester();
+    std::cout << c[5] << std::endl;
+}
@@ -0,0 +1,145 @@
+#include "src.hpp"
+#include "static-lru.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: the order of a small cache",
+    "test2: the same hits and order as lru",
+    "test3: no allocation after construction",
+    "test4: keys with a power-of-two stride",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+// every operator new of the program is counted
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+size_t news = 0;
+void *operator new(size_t n){
+    news++;
+    void *p = std::malloc(n ? n : 1);
+    if(!p) throw std::bad_alloc();
+    return p;
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+void fail(int line){
+    std::cout<<c[1]<<" "<<line<<std::endl;
+    exit(0);
+}
+
+unsigned int seed = 1732;
+int next_rand(){
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 16) & 0x7fff;
+}
+
+using value_type = sjtu::pair<Integer,Matrix<int> >;
+
+template <class Cache>
+std::string text(Cache &cache){
+    std::ostringstream out;
+    cache.for_each([&out](const Integer &key, const Matrix<int> &value){
+        out<<key.val<<" "<<value<<"\n";
+    });
+    return out.str();
+}
+
+void static_lru_tester(){
+    //test: saves, an update and a hit reorder, the oldest goes first
+    std::cout<<c[2]<<std::endl;
+    {
+        sjtu::static_lru<Integer,Matrix<int>,4,Hash,Equal> tester;
+        if(tester.BUCKETS != 8 || tester.capacity() != 4) fail(__LINE__);
+        for(int i=0;i<4;i++)
+            tester.save(value_type(Integer(i),Matrix<int>(1,2,i)));
+        tester.save(value_type(Integer(1),Matrix<int>(1,2,10)));
+        if(!tester.get(Integer(0))) fail(__LINE__);
+        tester.save(value_type(Integer(4),Matrix<int>(1,2,4)));
+        if(tester.get(Integer(2)) || tester.size() != 4) fail(__LINE__);
+        tester.print();
+        tester.clear();
+        if(!tester.empty() || tester.get(Integer(0))) fail(__LINE__);
+    }
+    if(Integer::counter) fail(__LINE__);
+
+    //test: a random mix against lru
+    std::cout<<c[3]<<std::endl;
+    {
+        static sjtu::static_lru<Integer,Matrix<int>,100,Hash,Equal> tester;
+        sjtu::lru plain(100);
+        int hits = 0;
+        for(int i=0;i<50000;i++){
+            int key = next_rand() % 250;
+            if(next_rand() % 3 == 0){
+                Matrix<int> m(1,1,i);
+                tester.save(value_type(Integer(key),m));
+                plain.save(value_type(Integer(key),m));
+            }else{
+                Matrix<int> *a = tester.get(Integer(key));
+                Matrix<int> *b = plain.get(Integer(key));
+                if(!a != !b || (a && !(*a == *b))) fail(__LINE__);
+                hits += a != nullptr;
+            }
+        }
+        if(text(tester) != text(plain)) fail(__LINE__);
+        std::cout<<hits<<" "<<tester.size()<<std::endl;
+        tester.clear();
+    }
+
+    //test: an int cache on the stack never calls operator new
+    std::cout<<c[4]<<std::endl;
+    {
+        size_t before = news;
+        sjtu::static_lru<int,int,512> tester;
+        int hits = 0;
+        for(int i=0;i<100000;i++){
+            int key = next_rand() % 1024;
+            int *res = tester.get(key);
+            if(res){
+                if(*res != key * 3) fail(__LINE__);
+                hits++;
+            }else{
+                tester.save(sjtu::static_lru<int,int,512>::value_type(key,key * 3));
+            }
+        }
+        std::cout<<hits<<" "<<news - before<<std::endl;
+        if(news != before) fail(__LINE__);
+    }
+
+    //test: Hash is the identity, the keys still spread over the buckets
+    std::cout<<c[5]<<std::endl;
+    {
+        static sjtu::static_lru<Integer,Matrix<int>,256,Hash,Equal> tester;
+        for(int i=0;i<300;i++)
+            tester.save(value_type(Integer(i * 1024),Matrix<int>(1,1,i)));
+        for(int i=0;i<300;i++){
+            Matrix<int> *res = tester.get(Integer(i * 1024));
+            if(!res != (i < 44) || (res && !(*res == Matrix<int>(1,1,i)))) fail(__LINE__);
+        }
+        sjtu::table_diagnostics d = tester.diagnostics();
+        if(d.size != 256 || d.max_chain > 8) fail(__LINE__);
+        std::cout<<d.size<<" "<<d.capacity<<" "<<d.max_chain<<std::endl;
+        tester.clear();
+    }
+    if(Integer::counter) fail(__LINE__);
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("30.out","w",stdout);
+#endif
+    static_lru_tester();
+    std::cout << c[6] << std::endl;
+}
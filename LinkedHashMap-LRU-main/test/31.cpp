@@ -0,0 +1,171 @@
+#include "src.hpp"
+#include "compact-hashmap.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: the same order as linked_hashmap",
+    "test2: iterators across growth, copies and errors",
+    "test3: fewer bytes per entry",
+    "test4: keys with a power-of-two stride",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void fail(int line){
+    std::cout<<c[1]<<" "<<line<<std::endl;
+    exit(0);
+}
+
+unsigned int seed = 3141;
+int next_rand(){
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 16) & 0x7fff;
+}
+
+using compact = sjtu::compact_linked_hashmap<Integer,Matrix<int>,Hash,Equal>;
+using linked = sjtu::linked_hashmap<Integer,Matrix<int>,Hash,Equal>;
+using value_type = sjtu::pair<const Integer,Matrix<int> >;
+
+// forward and backward, the keys and values of both must match
+void same(compact &a, linked &b){
+    if(a.size() != b.size()) fail(__LINE__);
+    auto j = b.begin();
+    for(auto i = a.begin();i != a.end();++i,++j){
+        if(j == b.end()) fail(__LINE__);
+        if(i->first.val != j->first.val || !(i->second == j->second)) fail(__LINE__);
+    }
+    if(j != b.end()) fail(__LINE__);
+    if(a.empty()) return;
+    auto i = a.end();
+    j = b.end();
+    do{
+        --i;
+        --j;
+        if(i->first.val != j->first.val) fail(__LINE__);
+    }while(i != a.begin());
+}
+
+void compact_tester(){
+    //test: a random mix of inserts, updates, removes and reorders
+    std::cout<<c[2]<<std::endl;
+    {
+        compact a;
+        linked b;
+        for(int i=0;i<30000;i++){
+            int key = next_rand() % 2000;
+            int op = next_rand() % 4;
+            if(op < 2){
+                value_type v(Integer(key),Matrix<int>(1,1,i));
+                if(a.insert(v).second != b.insert(v).second) fail(__LINE__);
+            }else if(op == 2){
+                auto x = a.find(Integer(key));
+                auto y = b.find(Integer(key));
+                if((x == a.end()) != (y == b.end())) fail(__LINE__);
+                if(x != a.end()){
+                    a.remove(x);
+                    b.remove(y);
+                }
+            }else{
+                auto x = a.find(Integer(key));
+                if(x != a.end()){
+                    a.move_to_back(x);
+                    b.move_to_back(b.find(Integer(key)));
+                }
+                if(a.count(Integer(key)) != b.count(Integer(key))) fail(__LINE__);
+            }
+            if(i % 5000 == 0) same(a,b);
+        }
+        same(a,b);
+        std::cout<<a.size()<<" "<<a.capacity()<<std::endl;
+        a.clear();
+        if(!a.empty() || a.begin() != a.end()) fail(__LINE__);
+        a.insert(value_type(Integer(1),Matrix<int>(1,1,1)));
+        if(a.size() != 1 || a.at(Integer(1))[0][0] != 1) fail(__LINE__);
+    }
+    if(Integer::counter) fail(__LINE__);
+
+    //test: an iterator is a slot number and survives the array growing
+    std::cout<<c[3]<<std::endl;
+    {
+        sjtu::compact_linked_hashmap<int,int> a;
+        auto first = a.insert(sjtu::pair<const int,int>(7,70)).first;
+        for(int i=0;i<1000;i++)
+            a.insert(sjtu::pair<const int,int>(i + 100,i));
+        if(first->second != 70 || a.begin() != first) fail(__LINE__);
+        if(a.insert(sjtu::pair<const int,int>(7,71)).second) fail(__LINE__);
+        if(a.at(7) != 71 || --a.end() != first) fail(__LINE__);
+        sjtu::compact_linked_hashmap<int,int> b(a);
+        sjtu::compact_linked_hashmap<int,int> d;
+        d = a;
+        a.remove(a.find(7));
+        if(b.size() != 1001 || d.size() != 1001 || a.size() != 1000) fail(__LINE__);
+        if((--b.end())->first != 7 || d.begin()->first != 100) fail(__LINE__);
+        int thrown = 0;
+        try{ a.at(7); }catch(const std::runtime_error &){ thrown++; }
+        try{ a.remove(a.end()); }catch(const std::runtime_error &){ thrown++; }
+        try{ ++a.end(); }catch(const std::runtime_error &){ thrown++; }
+        try{ --a.begin(); }catch(const std::runtime_error &){ thrown++; }
+        std::cout<<thrown<<std::endl;
+
+        std::pmr::monotonic_buffer_resource arena;
+        sjtu::compact_linked_hashmap<int,int,std::hash<int>,std::equal_to<int>,
+            std::pmr::polymorphic_allocator<sjtu::pair<const int,int> > > p(&arena);
+        for(int i=0;i<100;i++)
+            p.insert(sjtu::pair<const int,int>(i,i * i));
+        int sum = 0;
+        for(auto i = p.cbegin();i != p.cend();++i)
+            sum += i->second;
+        std::cout<<sum<<std::endl;
+    }
+
+    //test: the table and the slots take less than the nodes
+    std::cout<<c[4]<<std::endl;
+    {
+        sjtu::compact_linked_hashmap<int,int> a;
+        sjtu::linked_hashmap<int,int> b;
+        for(int i=0;i<10000;i++){
+            a.insert(sjtu::pair<const int,int>(i,i));
+            b.insert(sjtu::pair<const int,int>(i,i));
+        }
+        sjtu::table_diagnostics x = a.diagnostics(), y = b.diagnostics();
+        if(x.size != 10000 || x.load_factor() > 0.75) fail(__LINE__);
+        if(2 * x.node_bytes > y.node_bytes) fail(__LINE__);
+        if(x.bucket_bytes >= y.bucket_bytes) fail(__LINE__);
+        std::cout<<x.max_chain<<" "<<(x.probes_hit < 2)<<std::endl;
+    }
+
+    //test: Hash is the identity, the keys still spread over the buckets
+    std::cout<<c[5]<<std::endl;
+    {
+        compact a;
+        for(int i=0;i<4096;i++)
+            a.insert(value_type(Integer(i * 1024),Matrix<int>(1,1,i)));
+        for(int i=0;i<4096;i += 2)
+            a.remove(a.find(Integer(i * 1024)));
+        for(int i=0;i<4096;i++){
+            auto x = a.find(Integer(i * 1024));
+            if((x == a.end()) != (i % 2 == 0)) fail(__LINE__);
+            if(x != a.end() && x->second[0][0] != i) fail(__LINE__);
+        }
+        sjtu::table_diagnostics d = a.diagnostics();
+        if(d.size != 2048 || d.max_chain > 8) fail(__LINE__);
+        std::cout<<d.size<<" "<<d.capacity<<" "<<d.max_chain<<std::endl;
+    }
+    if(Integer::counter) fail(__LINE__);
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("31.out","w",stdout);
+#endif
+    compact_tester();
+    std::cout << c[6] << std::endl;
+}
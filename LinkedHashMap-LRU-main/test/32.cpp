@@ -0,0 +1,163 @@
+#include "src.hpp"
+#include "ordered-dict.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: the same order as linked_hashmap",
+    "test2: slot widths, holes and compaction",
+    "test3: fewer bytes per entry",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void fail(int line){
+    std::cout<<c[1]<<" "<<line<<std::endl;
+    exit(0);
+}
+
+unsigned int seed = 1618;
+int next_rand(){
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 16) & 0x7fff;
+}
+
+using dict = sjtu::ordered_dict<Integer,Matrix<int>,Hash,Equal>;
+using linked = sjtu::linked_hashmap<Integer,Matrix<int>,Hash,Equal>;
+using value_type = sjtu::pair<const Integer,Matrix<int> >;
+using int_pair = sjtu::pair<const int,int>;
+
+// forward and backward, the keys and values of both must match
+void same(dict &a, linked &b){
+    if(a.size() != b.size()) fail(__LINE__);
+    auto j = b.begin();
+    for(auto i = a.begin();i != a.end();++i,++j){
+        if(j == b.end()) fail(__LINE__);
+        if(i->first.val != j->first.val || !(i->second == j->second)) fail(__LINE__);
+    }
+    if(j != b.end()) fail(__LINE__);
+    if(a.empty()) return;
+    auto i = a.end();
+    j = b.end();
+    do{
+        --i;
+        --j;
+        if(i->first.val != j->first.val) fail(__LINE__);
+    }while(i != a.begin());
+}
+
+void dict_tester(){
+    //test: a random mix of inserts, updates, removes and reorders
+    std::cout<<c[2]<<std::endl;
+    {
+        dict a;
+        linked b;
+        for(int i=0;i<30000;i++){
+            int key = next_rand() % 2000;
+            int op = next_rand() % 4;
+            if(op < 2){
+                value_type v(Integer(key),Matrix<int>(1,1,i));
+                auto x = a.insert(v);
+                if(x.second != b.insert(v).second) fail(__LINE__);
+                if(x.first->first.val != key || --a.end() != x.first) fail(__LINE__);
+            }else if(op == 2){
+                auto x = a.find(Integer(key));
+                auto y = b.find(Integer(key));
+                if((x == a.end()) != (y == b.end())) fail(__LINE__);
+                if(x != a.end()){
+                    a.remove(x);
+                    b.remove(y);
+                }
+            }else{
+                auto x = a.find(Integer(key));
+                if(x != a.end()){
+                    a.move_to_back(x);
+                    b.move_to_back(b.find(Integer(key)));
+                }
+                if(a.count(Integer(key)) != b.count(Integer(key))) fail(__LINE__);
+            }
+            if(i % 5000 == 0) same(a,b);
+        }
+        same(a,b);
+        std::cout<<a.size()<<" "<<a.capacity()<<std::endl;
+        dict copy(a), assigned;
+        assigned = a;
+        a.clear();
+        if(!a.empty() || a.begin() != a.end()) fail(__LINE__);
+        same(copy,b);
+        same(assigned,b);
+    }
+    if(Integer::counter) fail(__LINE__);
+
+    //test: the table widens with the array, removals leave holes
+    std::cout<<c[3]<<std::endl;
+    {
+        sjtu::ordered_dict<int,int> a;
+        std::cout<<a.slot_width();
+        for(int i=0;i<100000;i++){
+            a.insert(int_pair(i,i));
+            if(i == 100 || i == 1000) std::cout<<" "<<a.slot_width();
+        }
+        std::cout<<" "<<a.slot_width()<<std::endl;
+        // remove all but every tenth, the survivors keep their place
+        for(int i=0;i<100000;i++)
+            if(i % 10) a.remove(a.find(i));
+        auto kept = a.find(500);
+        for(int i=0;i<100000;i+=10)
+            if(a.at(i) != i) fail(__LINE__);
+        if(kept->first != 500 || a.begin()->first != 0) fail(__LINE__);
+        long long sum = 0;
+        for(auto i = a.cbegin();i != a.cend();++i)
+            sum += i->second;
+        size_t before = a.capacity();
+        a.compact();
+        long long again = 0;
+        for(auto i = a.cbegin();i != a.cend();++i)
+            again += i->second;
+        std::cout<<sum<<" "<<(sum == again)<<" "<<(a.capacity() == before)<<std::endl;
+        // the array fills with holes, a rebuild squeezes them out
+        sjtu::ordered_dict<int,int> b;
+        size_t room = b.capacity();
+        for(int i=0;i<100;i++)
+            b.insert(int_pair(i % 10,i));
+        if(b.size() != 10 || b.capacity() != room || b.at(3) != 93) fail(__LINE__);
+        int first = b.begin()->first;
+        std::cout<<first<<" "<<(--b.end())->first<<std::endl;
+        int thrown = 0;
+        try{ b.at(10); }catch(const std::runtime_error &){ thrown++; }
+        try{ b.remove(b.end()); }catch(const std::runtime_error &){ thrown++; }
+        try{ ++b.end(); }catch(const std::runtime_error &){ thrown++; }
+        try{ --b.begin(); }catch(const std::runtime_error &){ thrown++; }
+        std::cout<<thrown<<std::endl;
+    }
+
+    //test: the table and the entries take less than the nodes
+    std::cout<<c[4]<<std::endl;
+    {
+        sjtu::ordered_dict<int,int> a;
+        sjtu::linked_hashmap<int,int> b;
+        for(int i=0;i<10000;i++){
+            a.insert(int_pair(i,i));
+            b.insert(int_pair(i,i));
+        }
+        sjtu::table_diagnostics x = a.diagnostics(), y = b.diagnostics();
+        if(x.size != 10000 || x.load_factor() > 2.0 / 3) fail(__LINE__);
+        if(4 * x.node_bytes > y.node_bytes) fail(__LINE__);
+        if(x.bucket_bytes >= y.bucket_bytes) fail(__LINE__);
+        std::cout<<(x.probes_hit < 2)<<" "<<(x.probes_miss < 4)<<std::endl;
+    }
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("32.out","w",stdout);
+#endif
+    dict_tester();
+    std::cout << c[5] << std::endl;
+}
@@ -0,0 +1,123 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: loop longer than the cache",
+    "test2: hot set under scans",
+    "test3: values and size",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+unsigned int seed = 20240311;
+int next_rand(){
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 8) & 0xffffff;
+}
+
+template<class Cache>
+int run(Cache &cache,int key){
+    using value_type = sjtu::pair<Integer,Matrix<int> >;
+    Matrix<int> *res = cache.get(Integer(key));
+    if(res){
+        if(!((*res) == Matrix<int>(2,2,key))){
+            std::cout<<c[1]<<std::endl;
+            exit(0);
+        }
+        return 1;
+    }
+    cache.save(value_type(Integer(key),Matrix<int>(2,2,key)));
+    return 0;
+}
+
+void arc_tester(){
+    using cache_arc = sjtu::arc<Integer,Matrix<int>,Hash,Equal>;
+    const int n = 100;
+
+    //test: a loop of 3n/2 keys, repeated, with a few keys reused in between
+    std::cout<<c[2]<<std::endl;
+    {
+        sjtu::lru lru_cache(n);
+        cache_arc arc_cache(n);
+        int lru_hits = 0, arc_hits = 0;
+        for(int round=0;round<20;round++){
+            for(int i=0;i<3*n/2;i++){
+                lru_hits += run(lru_cache,i);
+                arc_hits += run(arc_cache,i);
+                if(i % 3 == 0){
+                    lru_hits += run(lru_cache,i / 3);
+                    arc_hits += run(arc_cache,i / 3);
+                }
+            }
+        }
+        std::cout<<"lru hits: "<<lru_hits<<std::endl;
+        std::cout<<"arc hits: "<<arc_hits<<std::endl;
+    }
+
+    //test: a hot set interrupted by long scans of fresh keys
+    std::cout<<c[3]<<std::endl;
+    {
+        sjtu::lru lru_cache(n);
+        cache_arc arc_cache(n);
+        int lru_hits = 0, arc_hits = 0, fresh = 1000000;
+        for(int round=0;round<50;round++){
+            for(int i=0;i<400;i++){
+                int key = next_rand() % (n / 2);
+                lru_hits += run(lru_cache,key);
+                arc_hits += run(arc_cache,key);
+            }
+            for(int i=0;i<2*n;i++){
+                lru_hits += run(lru_cache,fresh);
+                arc_hits += run(arc_cache,fresh);
+                fresh++;
+            }
+        }
+        std::cout<<"lru hits: "<<lru_hits<<std::endl;
+        std::cout<<"arc hits: "<<arc_hits<<std::endl;
+    }
+
+    //test: values are updated in place and the size never exceeds n
+    std::cout<<c[4]<<std::endl;
+    {
+        using value_type = sjtu::pair<Integer,Matrix<int> >;
+        cache_arc arc_cache(n);
+        for(int i=0;i<10*n;i++){
+            arc_cache.save(value_type(Integer(i % (2*n)),Matrix<int>(2,2,i)));
+            if(arc_cache.size() > n || arc_cache.recency_target() > n){
+                std::cout<<c[1]<<std::endl;
+                exit(0);
+            }
+        }
+        for(int i=9*n;i<10*n;i++){
+            Matrix<int> *res = arc_cache.get(Integer(i % (2*n)));
+            if(res && !((*res) == Matrix<int>(2,2,i))){
+                std::cout<<c[1]<<std::endl;
+                exit(0);
+            }
+        }
+        std::cout<<arc_cache.size()<<std::endl;
+        // a capacity of 0 keeps nothing and never throws
+        cache_arc empty(0);
+        for(int i=0;i<10;i++)
+            empty.save(value_type(Integer(i),Matrix<int>(1,1,i)));
+        if(empty.size() || empty.get(Integer(3))){
+            std::cout<<c[1]<<std::endl;
+            exit(0);
+        }
+        std::cout<<empty.size()<<std::endl;
+    }
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("9.out","w",stdout);
+#endif
+    arc_tester();
+    std::cout << c[5] << std::endl;
+}